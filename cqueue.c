@@ -0,0 +1,231 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cqueue.h"
+
+#define CACHE_LINE 64
+#define SPIN_BEFORE_WAIT 64  // неудачных попыток перед сном на условной переменной
+
+/*
+ * Ячейка очереди. seq говорит, чья очередь её трогать:
+ * seq == pos         — ячейка свободна для писателя с номером pos;
+ * seq == pos + 1     — в ней данные для читателя с номером pos;
+ * seq == pos + cap   — освобождена читателем, ждёт писателя следующего круга.
+ */
+typedef struct {
+    atomic_size_t seq;
+    int           service_time;
+    int           id_len;
+    char          id[MAX_ID_LEN];
+} cq_cell_t;
+
+struct cqueue {
+    _Alignas(CACHE_LINE) atomic_size_t enq_pos;  // следующий номер для писателя
+    _Alignas(CACHE_LINE) atomic_size_t deq_pos;  // следующий номер для читателя
+
+    _Alignas(CACHE_LINE) size_t mask;
+    cq_cell_t*      cells;
+    atomic_int      closed;
+    atomic_int      waiters;    // потоков в ожидании (читатели и писатели)
+    pthread_mutex_t lock;       // только для ожидания
+    pthread_cond_t  not_empty;
+    pthread_cond_t  not_full;
+};
+
+cqueue_t* cqueue_create(size_t capacity) {
+    if (capacity == 0) return NULL;
+    size_t cap = 2;
+    while (cap < capacity) cap *= 2;
+
+    cqueue_t* q = aligned_alloc(CACHE_LINE, sizeof(cqueue_t));
+    if (!q) return NULL;
+    memset(q, 0, sizeof(*q));
+    q->cells = malloc(cap * sizeof(cq_cell_t));
+    if (!q->cells) {
+        free(q);
+        return NULL;
+    }
+    for (size_t i = 0; i < cap; i++) atomic_init(&q->cells[i].seq, i);
+    atomic_init(&q->enq_pos, 0);
+    atomic_init(&q->deq_pos, 0);
+    atomic_init(&q->closed, 0);
+    atomic_init(&q->waiters, 0);
+    q->mask = cap - 1;
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->not_empty, NULL);
+    pthread_cond_init(&q->not_full, NULL);
+    return q;
+}
+
+void cqueue_destroy(cqueue_t* q) {
+    if (!q) return;
+    pthread_mutex_destroy(&q->lock);
+    pthread_cond_destroy(&q->not_empty);
+    pthread_cond_destroy(&q->not_full);
+    free(q->cells);
+    free(q);
+}
+
+/* Будит ждущих на cond, если такие есть. Барьер парный к cqueue_wait. */
+static void cqueue_wake(cqueue_t* q, pthread_cond_t* cond) {
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&q->waiters, memory_order_relaxed) == 0) return;
+    pthread_mutex_lock(&q->lock);
+    pthread_cond_broadcast(cond);
+    pthread_mutex_unlock(&q->lock);
+}
+
+/* Постановка без пробуждения ждущих: 0 или -1 (полно/закрыто) */
+static int cq_push(cqueue_t* q, const char* passenger_id, size_t id_len, int service_time) {
+    if (atomic_load_explicit(&q->closed, memory_order_relaxed)) return -1;
+    size_t pos = atomic_load_explicit(&q->enq_pos, memory_order_relaxed);
+    cq_cell_t* cell;
+    for (;;) {
+        cell = &q->cells[pos & q->mask];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->enq_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return -1;  // ячейка ещё не освобождена читателем прошлого круга — полно
+        } else {
+            pos = atomic_load_explicit(&q->enq_pos, memory_order_relaxed);
+        }
+    }
+    if (id_len > MAX_ID_LEN - 1) id_len = MAX_ID_LEN - 1;
+    memcpy(cell->id, passenger_id, id_len);
+    cell->id[id_len] = '\0';
+    cell->id_len = (int)id_len;
+    cell->service_time = service_time;
+    atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+    return 0;
+}
+
+/* Извлечение без пробуждения ждущих: 0 или -1 (пусто) */
+static int cq_pop(cqueue_t* q, char out_id[MAX_ID_LEN], int* service_time) {
+    size_t pos = atomic_load_explicit(&q->deq_pos, memory_order_relaxed);
+    cq_cell_t* cell;
+    for (;;) {
+        cell = &q->cells[pos & q->mask];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->deq_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return -1;  // писатель ещё не заполнил ячейку — пусто
+        } else {
+            pos = atomic_load_explicit(&q->deq_pos, memory_order_relaxed);
+        }
+    }
+    memcpy(out_id, cell->id, (size_t)cell->id_len + 1);
+    if (service_time) *service_time = cell->service_time;
+    atomic_store_explicit(&cell->seq, pos + q->mask + 1, memory_order_release);
+    return 0;
+}
+
+int cqueue_try_enqueue(cqueue_t* q, const char* passenger_id, size_t id_len, int service_time) {
+    if (cq_push(q, passenger_id, id_len, service_time) < 0) return -1;
+    cqueue_wake(q, &q->not_empty);
+    return 0;
+}
+
+int cqueue_try_dequeue(cqueue_t* q, char out_id[MAX_ID_LEN], int* service_time) {
+    if (cq_pop(q, out_id, service_time) < 0) return -1;
+    cqueue_wake(q, &q->not_full);
+    return 0;
+}
+
+/*
+ * Ожидание: регистрируемся в waiters, затем под мьютексом повторяем попытку.
+ * Сторона, изменившая очередь, после своей записи проверяет waiters
+ * (cqueue_wake), а будит под тем же мьютексом — сигнал не теряется.
+ * Попытки не будят других сами (мьютекс может быть у нас), поэтому после
+ * успеха будим ждущих на other.
+ */
+typedef int (*cq_attempt_fn)(cqueue_t* q, void* arg);
+
+static int cqueue_wait(cqueue_t* q, pthread_cond_t* cond, pthread_cond_t* other,
+                       cq_attempt_fn attempt, void* arg) {
+    for (int spins = 0; spins < SPIN_BEFORE_WAIT; spins++) {
+        int rc = attempt(q, arg);
+        if (rc != 0 && atomic_load_explicit(&q->closed, memory_order_acquire)) rc = attempt(q, arg);
+        if (rc == 0) {
+            cqueue_wake(q, other);
+            return 0;
+        }
+        if (atomic_load_explicit(&q->closed, memory_order_acquire)) return -1;
+        sched_yield();
+    }
+    pthread_mutex_lock(&q->lock);
+    atomic_fetch_add_explicit(&q->waiters, 1, memory_order_seq_cst);
+    // Пара к барьеру в cqueue_wake (Деккер): либо мы увидим чужую запись в ячейку,
+    // либо та сторона увидит waiters > 0. Одного RMW для этого в C11 мало —
+    // полным барьером он оказывается только на x86
+    atomic_thread_fence(memory_order_seq_cst);
+    int rc;
+    for (;;) {
+        rc = attempt(q, arg);
+        if (rc == 0 || atomic_load_explicit(&q->closed, memory_order_acquire)) break;
+        pthread_cond_wait(cond, &q->lock);
+    }
+    atomic_fetch_sub_explicit(&q->waiters, 1, memory_order_relaxed);
+    pthread_mutex_unlock(&q->lock);
+    if (rc == 0) cqueue_wake(q, other);
+    return rc;
+}
+
+typedef struct {
+    const char* id;
+    size_t      id_len;
+    int         service_time;
+} cq_enq_arg_t;
+
+typedef struct {
+    char* id;
+    int*  service_time;
+} cq_deq_arg_t;
+
+static int attempt_enqueue(cqueue_t* q, void* arg) {
+    cq_enq_arg_t* a = arg;
+    return cq_push(q, a->id, a->id_len, a->service_time);
+}
+
+static int attempt_dequeue(cqueue_t* q, void* arg) {
+    cq_deq_arg_t* a = arg;
+    return cq_pop(q, a->id, a->service_time);
+}
+
+int cqueue_enqueue(cqueue_t* q, const char* passenger_id, size_t id_len, int service_time) {
+    cq_enq_arg_t a = { passenger_id, id_len, service_time };
+    if (cqueue_try_enqueue(q, passenger_id, id_len, service_time) == 0) return 0;
+    return cqueue_wait(q, &q->not_full, &q->not_empty, attempt_enqueue, &a);
+}
+
+int cqueue_dequeue(cqueue_t* q, char out_id[MAX_ID_LEN], int* service_time) {
+    cq_deq_arg_t a = { out_id, service_time };
+    if (cqueue_try_dequeue(q, out_id, service_time) == 0) return 0;
+    return cqueue_wait(q, &q->not_empty, &q->not_full, attempt_dequeue, &a);
+}
+
+void cqueue_close(cqueue_t* q) {
+    atomic_store_explicit(&q->closed, 1, memory_order_seq_cst);
+    pthread_mutex_lock(&q->lock);
+    pthread_cond_broadcast(&q->not_empty);
+    pthread_cond_broadcast(&q->not_full);
+    pthread_mutex_unlock(&q->lock);
+}
+
+size_t cqueue_size(const cqueue_t* q) {
+    size_t enq = atomic_load_explicit(&((cqueue_t*)q)->enq_pos, memory_order_acquire);
+    size_t deq = atomic_load_explicit(&((cqueue_t*)q)->deq_pos, memory_order_acquire);
+    return enq > deq ? enq - deq : 0;
+}
@@ -0,0 +1,51 @@
+#ifndef CQUEUE_H
+#define CQUEUE_H
+
+#include <stddef.h>
+#include "queue.h"
+
+/*
+ * Потокобезопасная очередь пассажиров (id + время обслуживания) для
+ * нескольких писателей и нескольких читателей одновременно.
+ * Основа — ограниченная очередь Вьюкова на массиве ячеек с порядковыми
+ * номерами: неблокирующие операции обходятся одним CAS без мьютексов.
+ * Блокирующие варианты ждут на условной переменной, только если очередь
+ * пуста (или полна), и не трогают мьютекс, пока никто не ждёт.
+ * id хранится прямо в ячейке, выделений памяти на операцию нет.
+ */
+typedef struct cqueue cqueue_t;
+
+/*
+ * Создаёт очередь не меньше чем на capacity пассажиров
+ * (ёмкость округляется вверх до степени двойки). NULL при ошибке.
+ */
+cqueue_t* cqueue_create(size_t capacity);
+
+/* Освобождает очередь. Никакой поток не должен в этот момент ею пользоваться. */
+void cqueue_destroy(cqueue_t* q);
+
+/*
+ * Добавляет пассажира с id passenger_id[0..id_len-1] (обрезается до
+ * MAX_ID_LEN - 1) без ожидания. Возвращает 0 или -1, если очередь полна.
+ */
+int cqueue_try_enqueue(cqueue_t* q, const char* passenger_id, size_t id_len, int service_time);
+
+/* То же, но ждёт места. Возвращает -1, если очередь закрыта. */
+int cqueue_enqueue(cqueue_t* q, const char* passenger_id, size_t id_len, int service_time);
+
+/*
+ * Забирает первого пассажира без ожидания: id (с '\0') в out_id,
+ * время обслуживания в *service_time. Возвращает 0 или -1, если пусто.
+ */
+int cqueue_try_dequeue(cqueue_t* q, char out_id[MAX_ID_LEN], int* service_time);
+
+/* То же, но ждёт пассажира. Возвращает -1, только если очередь закрыта и пуста. */
+int cqueue_dequeue(cqueue_t* q, char out_id[MAX_ID_LEN], int* service_time);
+
+/* Закрывает очередь: будит всех ждущих, новые пассажиры не принимаются. */
+void cqueue_close(cqueue_t* q);
+
+/* Примерное число пассажиров (точно, только если никто не меняет очередь). */
+size_t cqueue_size(const cqueue_t* q);
+
+#endif // CQUEUE_H
@@ -0,0 +1,285 @@
+/*
+ * Бенчмарк конкурентного доступа: пропускная способность cqueue_t
+ * против ограниченной queue_t (array той же ёмкости), обёрнутой в мьютекс
+ * и условные переменные, на 1, 2, 4, ... 64 потоках. Два сценария:
+ * - pairs    — каждый поток по кругу ставит пассажира и забирает
+ *              (неблокирующие операции, очередь почти пуста);
+ * - prodcons — половина потоков ставит, половина забирает блокирующим
+ *              dequeue (как стойки, разбирающие общий поток приходов).
+ * Печатает по одной JSON-строке на (реализация, сценарий, число потоков).
+ */
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "cqueue.h"
+#include "queue.h"
+
+#define DEFAULT_OPS   (1u << 21)  // операций (пар enqueue+dequeue) на один замер
+#define MAX_THREADS   64
+#define QUEUE_CAP     4096
+#define ID_LEN        8
+
+typedef enum { IMPL_CQUEUE, IMPL_MUTEX } bench_impl_t;
+typedef enum { MODE_PAIRS, MODE_PRODCONS } bench_mode_t;
+
+static const char* const impl_names[] = { "cqueue", "mutex_queue" };
+static const char* const mode_names[] = { "pairs", "prodcons" };
+
+
+// ----- queue_t под мьютексом (базовая линия) ----- //
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t  not_empty;
+    pthread_cond_t  not_full;
+    queue_t*        q;
+    int             closed;
+} locked_queue_t;
+
+/* Та же ёмкость QUEUE_CAP, что у cqueue_t: писатели так же ждут места */
+static int locked_init(locked_queue_t* lq) {
+    lq->q = queue_create_with(QUEUE_BACKEND_ARRAY, QUEUE_CAP);
+    if (!lq->q) return -1;
+    pthread_mutex_init(&lq->lock, NULL);
+    pthread_cond_init(&lq->not_empty, NULL);
+    pthread_cond_init(&lq->not_full, NULL);
+    lq->closed = 0;
+    return 0;
+}
+
+static void locked_destroy(locked_queue_t* lq) {
+    queue_destroy(lq->q);
+    pthread_mutex_destroy(&lq->lock);
+    pthread_cond_destroy(&lq->not_empty);
+    pthread_cond_destroy(&lq->not_full);
+}
+
+/* Ждёт места. 0 или -1, если очередь закрыта (или enqueue отказал) */
+static int locked_enqueue(locked_queue_t* lq, const char* id, int ts) {
+    pthread_mutex_lock(&lq->lock);
+    while (queue_size(lq->q) >= QUEUE_CAP && !lq->closed) {
+        pthread_cond_wait(&lq->not_full, &lq->lock);
+    }
+    int rc = lq->closed ? -1 : queue_enqueue_n(lq->q, id, ID_LEN, ts);
+    if (rc == 0) pthread_cond_signal(&lq->not_empty);
+    pthread_mutex_unlock(&lq->lock);
+    return rc;
+}
+
+/* block = 1 — ждать пассажира; -1, если пусто (или закрыто и пусто) */
+static int locked_dequeue(locked_queue_t* lq, char out[MAX_ID_LEN], int* ts, int block) {
+    pthread_mutex_lock(&lq->lock);
+    while (block && queue_empty(lq->q) && !lq->closed) {
+        pthread_cond_wait(&lq->not_empty, &lq->lock);
+    }
+    int rc = -1;
+    if (!queue_empty(lq->q)) {
+        strcpy(out, queue_front_id(lq->q));
+        *ts = queue_front_service_time(lq->q);
+        queue_dequeue(lq->q);
+        pthread_cond_signal(&lq->not_full);
+        rc = 0;
+    }
+    pthread_mutex_unlock(&lq->lock);
+    return rc;
+}
+
+static void locked_close(locked_queue_t* lq) {
+    pthread_mutex_lock(&lq->lock);
+    lq->closed = 1;
+    pthread_cond_broadcast(&lq->not_empty);
+    pthread_cond_broadcast(&lq->not_full);
+    pthread_mutex_unlock(&lq->lock);
+}
+
+
+// ----- Потоки ----- //
+
+typedef struct {
+    bench_impl_t    impl;
+    cqueue_t*       cq;
+    locked_queue_t* lq;
+    size_t          ops;       // операций на этот поток
+    int             producer;  // prodcons: 1 — ставит, 0 — забирает
+    size_t          done;      // выполнено (для читателей prodcons)
+    unsigned long   checksum;  // сумма забранных (ts + последний символ id)
+    unsigned long   sent;      // та же сумма по поставленным: с ней сверяется checksum
+    int             failed;    // enqueue отказал: пассажир потерян, замер недействителен
+} worker_t;
+
+static void* pairs_worker(void* arg) {
+    worker_t* w = arg;
+    char id[ID_LEN + 1] = "p0000000";
+    char out[MAX_ID_LEN];
+    int ts;
+    for (size_t i = 0; i < w->ops; i++) {
+        id[ID_LEN - 1] = (char)('0' + i % 10);
+        if (w->impl == IMPL_CQUEUE) {
+            while (cqueue_try_enqueue(w->cq, id, ID_LEN, (int)i) < 0) sched_yield();
+            // Пассажира мог забрать другой поток, но очередь не пуста, пока мы его не забрали
+            while (cqueue_try_dequeue(w->cq, out, &ts) < 0) sched_yield();
+        } else {
+            if (locked_enqueue(w->lq, id, (int)i) < 0) {
+                w->failed = 1;
+                break;
+            }
+            while (locked_dequeue(w->lq, out, &ts, 0) < 0) sched_yield();
+        }
+        w->sent += (unsigned long)i + (unsigned char)id[ID_LEN - 1];
+        w->checksum += (unsigned long)ts + (unsigned char)out[ID_LEN - 1];
+    }
+    if (!w->failed) w->done = w->ops;
+    return NULL;
+}
+
+static void* prodcons_worker(void* arg) {
+    worker_t* w = arg;
+    char id[ID_LEN + 1] = "p0000000";
+    char out[MAX_ID_LEN];
+    int ts;
+    if (w->producer) {
+        for (size_t i = 0; i < w->ops; i++) {
+            id[ID_LEN - 1] = (char)('0' + i % 10);
+            int rc = (w->impl == IMPL_CQUEUE) ? cqueue_enqueue(w->cq, id, ID_LEN, (int)i)
+                                              : locked_enqueue(w->lq, id, (int)i);
+            if (rc < 0) {
+                w->failed = 1;
+                break;
+            }
+            w->sent += (unsigned long)i + (unsigned char)id[ID_LEN - 1];
+        }
+        return NULL;
+    }
+    for (;;) {
+        int rc = (w->impl == IMPL_CQUEUE) ? cqueue_dequeue(w->cq, out, &ts)
+                                          : locked_dequeue(w->lq, out, &ts, 1);
+        if (rc < 0) break;
+        w->checksum += (unsigned long)ts + (unsigned char)out[ID_LEN - 1];
+        w->done++;
+    }
+    return NULL;
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* Один замер: threads потоков делят total операций */
+static int bench_one(bench_impl_t impl, bench_mode_t mode, int threads, size_t total) {
+    cqueue_t* cq = NULL;
+    locked_queue_t lq;
+    if (impl == IMPL_CQUEUE) {
+        cq = cqueue_create(QUEUE_CAP);
+        if (!cq) return -1;
+    } else if (locked_init(&lq) < 0) {
+        return -1;
+    }
+
+    // prodcons: минимум один писатель и один читатель
+    int producers = mode == MODE_PRODCONS ? (threads + 1) / 2 : threads;
+    int consumers = mode == MODE_PRODCONS ? (threads / 2 > 0 ? threads / 2 : 1) : 0;
+    int n = producers + consumers;
+    worker_t w[MAX_THREADS + 1];
+    pthread_t tid[MAX_THREADS + 1];
+    for (int i = 0; i < n; i++) {
+        memset(&w[i], 0, sizeof(w[i]));
+        w[i].impl = impl;
+        w[i].cq = cq;
+        w[i].lq = &lq;
+        w[i].producer = i < producers;
+        // Остаток от деления раздаётся первым писателям: всего ровно total
+        w[i].ops = w[i].producer ? total / (size_t)producers + ((size_t)i < total % (size_t)producers) : 0;
+    }
+
+    double t0 = now_sec();
+    int started = 0;
+    for (; started < n; started++) {
+        void* (*fn)(void*) = mode == MODE_PAIRS ? pairs_worker : prodcons_worker;
+        if (pthread_create(&tid[started], NULL, fn, &w[started]) != 0) break;
+    }
+    if (started < n) {
+        fprintf(stderr, "Error: failed to start %d threads\n", n);
+        // Уже запущенные дорабатывают: читателей отпускаем закрытием очереди
+    }
+    for (int i = 0; i < started && i < producers; i++) pthread_join(tid[i], NULL);
+    if (impl == IMPL_CQUEUE) cqueue_close(cq);
+    else                     locked_close(&lq);
+    for (int i = producers; i < started; i++) pthread_join(tid[i], NULL);
+    double dt = now_sec() - t0;
+
+    size_t ops = 0;
+    unsigned long checksum = 0, sent = 0;
+    int failed = 0;
+    for (int i = 0; i < started; i++) {
+        ops += mode == MODE_PAIRS || !w[i].producer ? w[i].done : 0;
+        checksum += w[i].checksum;
+        sent += w[i].sent;
+        failed |= w[i].failed;
+    }
+    if (failed) {
+        fprintf(stderr, "Error: %s %s: enqueue failed, passengers were lost\n",
+                impl_names[impl], mode_names[mode]);
+    }
+    printf("{\"impl\":\"%s\",\"mode\":\"%s\",\"threads\":%d,\"ops\":%zu,\"sec\":%.6f,"
+           "\"mops_per_sec\":%.3f,\"checksum\":%lu}\n",
+           impl_names[impl], mode_names[mode], n, ops, dt, dt > 0 ? ops / dt / 1e6 : 0.0, checksum);
+    fflush(stdout);
+    // Потерянный или повторно выданный пассажир меняет число операций или сумму
+    if (!failed && started == n && (ops != total || checksum != sent)) {
+        fprintf(stderr, "Error: %s %s on %d threads: %zu of %zu passengers dequeued, checksum %lu, expected %lu\n",
+                impl_names[impl], mode_names[mode], n, ops, total, checksum, sent);
+        failed = 1;
+    }
+
+    if (impl == IMPL_CQUEUE) cqueue_destroy(cq);
+    else                     locked_destroy(&lq);
+    return started == n && !failed ? 0 : -1;
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "Usage: %s [--max-threads=N] [--ops=N]\n"
+            "  --max-threads=N  largest thread count, counts go 1, 2, 4, ... (default %d)\n"
+            "  --ops=N          enqueue+dequeue pairs per measurement (default %u)\n",
+            prog, MAX_THREADS, DEFAULT_OPS);
+}
+
+int main(int argc, char** argv) {
+    int max_threads = MAX_THREADS;
+    size_t ops = DEFAULT_OPS;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--max-threads=", 14) == 0) {
+            max_threads = atoi(argv[i] + 14);
+            if (max_threads < 1 || max_threads > MAX_THREADS) {
+                fprintf(stderr, "Error: --max-threads must be in 1..%d\n", MAX_THREADS);
+                return 1;
+            }
+        } else if (strncmp(argv[i], "--ops=", 6) == 0) {
+            ops = strtoull(argv[i] + 6, NULL, 10);
+            if (ops < 1) {
+                fprintf(stderr, "Error: --ops must be positive\n");
+                return 1;
+            }
+        } else {
+            usage(argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    int rc = 0;
+    for (int mode = MODE_PAIRS; mode <= MODE_PRODCONS; mode++) {
+        // prodcons нужен хотя бы один писатель и один читатель
+        int first = mode == MODE_PRODCONS && max_threads >= 2 ? 2 : 1;
+        for (int threads = first; threads <= max_threads; threads *= 2) {
+            for (int impl = IMPL_CQUEUE; impl <= IMPL_MUTEX; impl++) {
+                if (bench_one((bench_impl_t)impl, (bench_mode_t)mode, threads, ops) < 0) rc = 1;
+            }
+        }
+    }
+    return rc;
+}
@@ -0,0 +1,269 @@
+/*
+ * Проверка cqueue_t: неблокирующие операции на полной и пустой очереди,
+ * порядок и обрезка id, закрытие (дочитывание остатка и пробуждение
+ * читателей, ждущих в блокирующем dequeue), и нагрузочный прогон
+ * многих писателей и читателей через маленькую очередь: каждый пассажир
+ * должен быть получен ровно один раз, а от одного писателя — по порядку.
+ * Печатает первую найденную ошибку и завершается с кодом 1.
+ */
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "cqueue.h"
+
+#define STRESS_PRODUCERS 4
+#define STRESS_CONSUMERS 4
+#define STRESS_ITEMS     20000  // пассажиров на одного писателя
+#define STRESS_CAP       16     // маленькая ёмкость: очередь часто полна и пуста
+
+#define CHECK(cond, ...) do {                                \
+    if (!(cond)) {                                           \
+        fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__); \
+        fprintf(stderr, __VA_ARGS__);                        \
+        fprintf(stderr, "\n");                               \
+        exit(1);                                             \
+    }                                                        \
+} while (0)
+
+static void sleep_ms(int ms) {
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+
+// ----- Один поток ----- //
+
+static void test_try_ops(void) {
+    // Ёмкость округляется вверх до степени двойки: 5 -> 8
+    cqueue_t* q = cqueue_create(5);
+    CHECK(q, "cqueue_create failed");
+    char id[16], out[MAX_ID_LEN];
+    int ts;
+    CHECK(cqueue_try_dequeue(q, out, &ts) == -1, "dequeue from an empty queue succeeded");
+    for (int i = 0; i < 8; i++) {
+        int len = snprintf(id, sizeof(id), "id%d", i);
+        CHECK(cqueue_try_enqueue(q, id, (size_t)len, 100 + i) == 0, "enqueue %d of 8 failed", i);
+    }
+    CHECK(cqueue_try_enqueue(q, "x", 1, 0) == -1, "enqueue into a full queue succeeded");
+    CHECK(cqueue_size(q) == 8, "size %zu, expected 8", cqueue_size(q));
+    for (int i = 0; i < 8; i++) {
+        snprintf(id, sizeof(id), "id%d", i);
+        CHECK(cqueue_try_dequeue(q, out, &ts) == 0, "dequeue %d of 8 failed", i);
+        CHECK(strcmp(out, id) == 0 && ts == 100 + i, "got %s/%d, expected %s/%d", out, ts, id, 100 + i);
+    }
+    CHECK(cqueue_try_dequeue(q, out, &ts) == -1, "dequeue from a drained queue succeeded");
+
+    // Несколько кругов по кольцу ячеек
+    for (int i = 0; i < 100; i++) {
+        CHECK(cqueue_try_enqueue(q, "ab", 2, i) == 0, "enqueue on lap %d failed", i);
+        CHECK(cqueue_try_dequeue(q, out, &ts) == 0 && ts == i, "dequeue on lap %d failed", i);
+    }
+
+    // id длиннее MAX_ID_LEN - 1 обрезается, id без '\0' читается по длине
+    char long_id[MAX_ID_LEN * 2];
+    memset(long_id, 'L', sizeof(long_id));
+    CHECK(cqueue_try_enqueue(q, long_id, sizeof(long_id), 7) == 0, "enqueue of a long id failed");
+    CHECK(cqueue_try_enqueue(q, "abcdef", 3, 8) == 0, "enqueue of an id slice failed");
+    CHECK(cqueue_try_dequeue(q, out, &ts) == 0, "dequeue of a long id failed");
+    CHECK(strlen(out) == MAX_ID_LEN - 1 && ts == 7, "long id not truncated to %d", MAX_ID_LEN - 1);
+    CHECK(cqueue_try_dequeue(q, out, &ts) == 0 && strcmp(out, "abc") == 0, "id slice read as %s", out);
+    cqueue_destroy(q);
+}
+
+static void test_close_drains(void) {
+    cqueue_t* q = cqueue_create(4);
+    CHECK(q, "cqueue_create failed");
+    char out[MAX_ID_LEN];
+    int ts;
+    CHECK(cqueue_enqueue(q, "a", 1, 1) == 0 && cqueue_enqueue(q, "b", 1, 2) == 0, "enqueue failed");
+    cqueue_close(q);
+    CHECK(cqueue_try_enqueue(q, "c", 1, 3) == -1, "try_enqueue after close succeeded");
+    CHECK(cqueue_enqueue(q, "c", 1, 3) == -1, "enqueue after close succeeded");
+    // Закрытая очередь отдаёт то, что в ней осталось, и только потом -1
+    CHECK(cqueue_dequeue(q, out, &ts) == 0 && strcmp(out, "a") == 0, "first item lost after close");
+    CHECK(cqueue_try_dequeue(q, out, &ts) == 0 && strcmp(out, "b") == 0, "second item lost after close");
+    CHECK(cqueue_dequeue(q, out, &ts) == -1, "dequeue from a closed empty queue succeeded");
+    cqueue_destroy(q);
+}
+
+
+// ----- Блокирующие операции и закрытие ----- //
+
+typedef struct {
+    cqueue_t*  q;
+    int        got;     // получено пассажиров
+    int        rc;      // результат последнего dequeue
+    atomic_int done;
+} waiter_t;
+
+static void* waiter_main(void* arg) {
+    waiter_t* w = arg;
+    char out[MAX_ID_LEN];
+    int ts;
+    while ((w->rc = cqueue_dequeue(w->q, out, &ts)) == 0) w->got++;
+    atomic_store(&w->done, 1);
+    return NULL;
+}
+
+static void* full_writer_main(void* arg) {
+    waiter_t* w = arg;
+    w->rc = cqueue_enqueue(w->q, "late", 4, 0);
+    atomic_store(&w->done, 1);
+    return NULL;
+}
+
+static void test_close_wakes_waiters(void) {
+    enum { WAITERS = 4 };
+    cqueue_t* q = cqueue_create(8);
+    CHECK(q, "cqueue_create failed");
+    waiter_t w[WAITERS];
+    pthread_t tid[WAITERS];
+    for (int i = 0; i < WAITERS; i++) {
+        memset(&w[i], 0, sizeof(w[i]));
+        w[i].q = q;
+        CHECK(pthread_create(&tid[i], NULL, waiter_main, &w[i]) == 0, "pthread_create failed");
+    }
+    // Читатели успевают уйти в ожидание на пустой очереди; каждый пассажир достаётся одному
+    sleep_ms(50);
+    for (int i = 0; i < 3; i++) CHECK(cqueue_enqueue(q, "p", 1, i) == 0, "enqueue failed");
+    sleep_ms(50);
+    for (int i = 0; i < WAITERS; i++) CHECK(!atomic_load(&w[i].done), "waiter %d returned before close", i);
+    cqueue_close(q);
+    int got = 0;
+    for (int i = 0; i < WAITERS; i++) {
+        pthread_join(tid[i], NULL);
+        CHECK(w[i].rc == -1, "waiter %d: dequeue returned %d after close", i, w[i].rc);
+        got += w[i].got;
+    }
+    CHECK(got == 3, "waiters got %d passengers, expected 3", got);
+    cqueue_destroy(q);
+
+    // Писатель, ждущий места в полной очереди, тоже просыпается с -1
+    q = cqueue_create(2);
+    CHECK(q, "cqueue_create failed");
+    CHECK(cqueue_try_enqueue(q, "a", 1, 0) == 0 && cqueue_try_enqueue(q, "b", 1, 0) == 0, "enqueue failed");
+    waiter_t fw;
+    memset(&fw, 0, sizeof(fw));
+    fw.q = q;
+    pthread_t ftid;
+    CHECK(pthread_create(&ftid, NULL, full_writer_main, &fw) == 0, "pthread_create failed");
+    sleep_ms(50);
+    CHECK(!atomic_load(&fw.done), "enqueue into a full queue returned without space");
+    cqueue_close(q);
+    pthread_join(ftid, NULL);
+    CHECK(fw.rc == -1, "writer: enqueue returned %d after close", fw.rc);
+    cqueue_destroy(q);
+}
+
+
+// ----- Нагрузка: многие писатели и читатели ----- //
+
+typedef struct {
+    cqueue_t*      q;
+    int            index;
+    int            blocking;        // 1 — cqueue_enqueue/dequeue, 0 — try_* с повтором
+    atomic_int*    producers_left;  // писателей ещё не закончило
+    unsigned char* seen;            // [STRESS_PRODUCERS * STRESS_ITEMS], общий для читателей
+    int            error;
+} stress_t;
+
+static void* stress_producer(void* arg) {
+    stress_t* s = arg;
+    char id[32];
+    for (int i = 0; i < STRESS_ITEMS; i++) {
+        int len = snprintf(id, sizeof(id), "%d:%d", s->index, i);
+        int key = s->index * STRESS_ITEMS + i;
+        if (s->blocking) {
+            if (cqueue_enqueue(s->q, id, (size_t)len, key) < 0) {
+                s->error = 1;
+                break;
+            }
+        } else {
+            while (cqueue_try_enqueue(s->q, id, (size_t)len, key) < 0) sched_yield();
+        }
+    }
+    // Последний писатель закрывает очередь: читатели дочитывают и выходят
+    if (atomic_fetch_sub(s->producers_left, 1) == 1) cqueue_close(s->q);
+    return NULL;
+}
+
+static void* stress_consumer(void* arg) {
+    stress_t* s = arg;
+    int last[STRESS_PRODUCERS];
+    for (int p = 0; p < STRESS_PRODUCERS; p++) last[p] = -1;
+    char out[MAX_ID_LEN], id[32];
+    int key;
+    for (;;) {
+        int rc = s->blocking ? cqueue_dequeue(s->q, out, &key) : cqueue_try_dequeue(s->q, out, &key);
+        if (rc < 0) {
+            if (s->blocking) break;
+            // Неблокирующий читатель выходит, когда писатели закончили и всё разобрано
+            if (atomic_load(s->producers_left) == 0 && cqueue_size(s->q) == 0) break;
+            sched_yield();
+            continue;
+        }
+        if (key < 0 || key >= STRESS_PRODUCERS * STRESS_ITEMS) {
+            s->error = 1;
+            break;
+        }
+        int p = key / STRESS_ITEMS, i = key % STRESS_ITEMS;
+        snprintf(id, sizeof(id), "%d:%d", p, i);
+        // id и время приехали из одной ячейки; от одного писателя — по возрастанию
+        if (strcmp(out, id) != 0 || i <= last[p]) {
+            s->error = 1;
+            break;
+        }
+        last[p] = i;
+        s->seen[key]++;  // у каждого key один читатель, если очередь не выдаёт дважды
+    }
+    return NULL;
+}
+
+static void test_stress(int blocking) {
+    cqueue_t* q = cqueue_create(STRESS_CAP);
+    CHECK(q, "cqueue_create failed");
+    unsigned char* seen = calloc(STRESS_PRODUCERS * STRESS_ITEMS, 1);
+    CHECK(seen, "calloc failed");
+    atomic_int producers_left;
+    atomic_init(&producers_left, STRESS_PRODUCERS);
+
+    stress_t s[STRESS_PRODUCERS + STRESS_CONSUMERS];
+    pthread_t tid[STRESS_PRODUCERS + STRESS_CONSUMERS];
+    for (int i = 0; i < STRESS_PRODUCERS + STRESS_CONSUMERS; i++) {
+        s[i] = (stress_t){ .q = q, .index = i, .blocking = blocking,
+                           .producers_left = &producers_left, .seen = seen };
+    }
+    // Читатели первыми: им приходится ждать на пустой очереди
+    for (int i = STRESS_PRODUCERS; i < STRESS_PRODUCERS + STRESS_CONSUMERS; i++) {
+        CHECK(pthread_create(&tid[i], NULL, stress_consumer, &s[i]) == 0, "pthread_create failed");
+    }
+    for (int i = 0; i < STRESS_PRODUCERS; i++) {
+        CHECK(pthread_create(&tid[i], NULL, stress_producer, &s[i]) == 0, "pthread_create failed");
+    }
+    for (int i = 0; i < STRESS_PRODUCERS + STRESS_CONSUMERS; i++) {
+        pthread_join(tid[i], NULL);
+        CHECK(!s[i].error, "%s thread %d saw a lost, duplicated, corrupted or reordered passenger",
+              blocking ? "blocking" : "try", i);
+    }
+    for (int k = 0; k < STRESS_PRODUCERS * STRESS_ITEMS; k++) {
+        CHECK(seen[k] == 1, "%s: passenger %d:%d dequeued %d times", blocking ? "blocking" : "try",
+              k / STRESS_ITEMS, k % STRESS_ITEMS, seen[k]);
+    }
+    CHECK(cqueue_size(q) == 0, "queue not empty after the run");
+    free(seen);
+    cqueue_destroy(q);
+}
+
+int main(void) {
+    test_try_ops();
+    test_close_drains();
+    test_close_wakes_waiters();
+    test_stress(1);
+    test_stress(0);
+    printf("cqueue_test: all checks passed\n");
+    return 0;
+}
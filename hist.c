@@ -0,0 +1,38 @@
+#include <string.h>
+#include "hist.h"
+
+void hist_init(hist_t* h) {
+    memset(h, 0, sizeof(*h));
+}
+
+/* Наибольшее значение, попадающее в корзину b */
+static int hist_bucket_high(int b) {
+    if (b < HIST_SUB_COUNT) return b;
+    int shift = (b - HIST_SUB_COUNT) / HIST_HALF_COUNT + 1;
+    long long mantissa = HIST_HALF_COUNT + (b - HIST_SUB_COUNT) % HIST_HALF_COUNT;
+    long long high = ((mantissa + 1) << shift) - 1;
+    return high > 0x7fffffff ? 0x7fffffff : (int)high;
+}
+
+int hist_quantile(const hist_t* h, double q) {
+    if (h->total == 0) return 0;
+    if (q <= 0) return h->min;
+    if (q >= 1) return h->max;
+    // Ранг ceil(q * total), как у nearest-rank
+    uint64_t rank = (uint64_t)(q * (double)h->total);
+    if ((double)rank < q * (double)h->total) rank++;
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < HIST_BUCKETS; b++) {
+        seen += h->counts[b];
+        if (seen >= rank) {
+            int v = hist_bucket_high(b);
+            return v < h->max ? v : h->max;
+        }
+    }
+    return h->max;
+}
+
+double hist_mean(const hist_t* h) {
+    return h->total ? h->sum / (double)h->total : 0.0;
+}
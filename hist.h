@@ -0,0 +1,55 @@
+#ifndef HIST_H
+#define HIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Гистограмма неотрицательных целых в духе HDR: логарифмически-линейные
+ * корзины. Значения до 2^HIST_SUB_BITS хранятся точно, дальше каждая
+ * степень двойки делится на 2^(HIST_SUB_BITS-1) корзин, так что
+ * относительная ошибка квантилей меньше 1/64. Память постоянная (~13 КБ),
+ * запись — несколько инструкций без выделений.
+ */
+#define HIST_SUB_BITS 7
+#define HIST_SUB_COUNT (1 << HIST_SUB_BITS)       // точные значения 0..127
+#define HIST_HALF_COUNT (HIST_SUB_COUNT / 2)      // корзин на степень двойки дальше
+#define HIST_BUCKETS (HIST_SUB_COUNT + (31 - HIST_SUB_BITS) * HIST_HALF_COUNT)
+
+typedef struct {
+    uint64_t counts[HIST_BUCKETS];
+    uint64_t total;
+    double   sum;
+    int      min;
+    int      max;
+} hist_t;
+
+void hist_init(hist_t* h);
+
+/* Номер корзины для v >= 0 */
+static inline int hist_bucket(int v) {
+    if (v < HIST_SUB_COUNT) return v;
+    int msb = 31 - __builtin_clz((unsigned)v);
+    int shift = msb - (HIST_SUB_BITS - 1);
+    return HIST_SUB_COUNT + (shift - 1) * HIST_HALF_COUNT + ((v >> shift) - HIST_HALF_COUNT);
+}
+
+/* Добавляет значение v (отрицательные считаются нулём) */
+static inline void hist_record(hist_t* h, int v) {
+    if (v < 0) v = 0;
+    h->counts[hist_bucket(v)]++;
+    if (h->total == 0 || v < h->min) h->min = v;
+    if (h->total == 0 || v > h->max) h->max = v;
+    h->total++;
+    h->sum += v;
+}
+
+/*
+ * Значение квантиля q (0..1): верхняя граница корзины, в которую он попал,
+ * но не больше максимума. Для пустой гистограммы — 0.
+ */
+int hist_quantile(const hist_t* h, double q);
+
+double hist_mean(const hist_t* h);
+
+#endif // HIST_H
@@ -1,6 +1,198 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "queue.h"
 
-int main(void) {
-    run_simulation();
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "Usage: %s [options] < input\n"
+            "  --backend=NAME      queue implementation for desks: list|array|ring|chunk\n"
+            "                      (default: %s)\n"
+            "  --policy=NAME       desk choice: power-of-d|jsq|least-work|round-robin\n"
+            "                      (default power-of-d)\n"
+            "  --choices=D         sampled desks for power-of-d (default 2)\n"
+            "  --seed=S            seed for desk choices (default 1)\n"
+            "  --queue-limit=L     at most L passengers per desk queue (default: unbounded,\n"
+            "                      1000 for the array backend)\n"
+            "  --overflow=NAME     when the chosen desk is full: reject|redirect|spill|\n"
+            "                      backpressure (default reject)\n"
+            "  --spill-limit=S     capacity of the shared spill queue (default: queue limit)\n"
+            "  --block-columns=K   print the table in blocks of K time columns as the\n"
+            "                      simulation advances (default: one block at the end)\n"
+            "  --events=FORMAT     write one record per arrival/departure/reject instead\n"
+            "                      of the table: csv|jsonl|binary\n"
+            "  --events-file=PATH  write the event log to PATH (default: stdout)\n"
+            "  --metrics           print wait/sojourn percentiles and desk utilization\n"
+            "                      instead of the table\n"
+            "  --pipeline          read and parse input on a separate thread while simulating\n"
+            "                      (for input already sorted by arrival time)\n"
+            "  --stream            simulate input as it arrives (e.g. from a live pipe)\n"
+            "                      without reading and sorting it first\n"
+            "  --lateness=L        --stream: accept passengers up to L time units behind\n"
+            "                      the latest arrival, drop later ones (default 0)\n"
+            "  --reorder-buffer=B  --stream: hold at most B out-of-order passengers\n"
+            "                      (default 65536)\n"
+            "  --replications=MAX  run up to MAX independent replications and print\n"
+            "                      a summary instead of the table\n"
+            "  --min-replications=K  run at least K replications (default 10)\n"
+            "  --ci=REL            stop once the 95%% CI of mean wait is within REL\n"
+            "                      of the mean (default 0.01, 0 = always MAX)\n"
+            "  --threads=T         worker threads for replications (default: all CPUs)\n",
+            prog, queue_backend_name(queue_default_backend()));
+}
+
+int main(int argc, char** argv) {
+    sim_config_t cfg;
+    sim_config_init(&cfg);
+    sim_replicate_config_t rc;
+    sim_replicate_config_init(&rc);
+    int replicate = 0;
+    int metrics = 0;
+    int pipeline = 0;
+    sim_stream_config_t sc;
+    sim_stream_config_init(&sc);
+    int stream = 0;
+    const char* events_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (strncmp(arg, "--backend=", 10) == 0) {
+            if (queue_backend_from_name(arg + 10, &cfg.backend) < 0) {
+                fprintf(stderr, "Error: unknown queue backend '%s'\n", arg + 10);
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (strncmp(arg, "--policy=", 9) == 0) {
+            if (sim_policy_from_name(arg + 9, &cfg.policy) < 0) {
+                fprintf(stderr, "Error: unknown dispatch policy '%s'\n", arg + 9);
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (strncmp(arg, "--choices=", 10) == 0) {
+            cfg.choices = atoi(arg + 10);
+            if (cfg.choices < 1) {
+                fprintf(stderr, "Error: --choices must be at least 1\n");
+                return 1;
+            }
+        } else if (strncmp(arg, "--queue-limit=", 14) == 0) {
+            long v = atol(arg + 14);
+            if (v < 1) {
+                fprintf(stderr, "Error: --queue-limit must be at least 1\n");
+                return 1;
+            }
+            cfg.queue_limit = (size_t)v;
+        } else if (strncmp(arg, "--overflow=", 11) == 0) {
+            if (sim_overflow_from_name(arg + 11, &cfg.overflow) < 0) {
+                fprintf(stderr, "Error: unknown overflow policy '%s'\n", arg + 11);
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (strncmp(arg, "--spill-limit=", 14) == 0) {
+            long v = atol(arg + 14);
+            if (v < 1) {
+                fprintf(stderr, "Error: --spill-limit must be at least 1\n");
+                return 1;
+            }
+            cfg.spill_limit = (size_t)v;
+        } else if (strncmp(arg, "--block-columns=", 16) == 0) {
+            long v = atol(arg + 16);
+            if (v < 1) {
+                fprintf(stderr, "Error: --block-columns must be at least 1\n");
+                return 1;
+            }
+            cfg.table_block = (size_t)v;
+        } else if (strncmp(arg, "--events=", 9) == 0) {
+            if (sim_events_format_from_name(arg + 9, &cfg.events) < 0) {
+                fprintf(stderr, "Error: unknown event log format '%s'\n", arg + 9);
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (strncmp(arg, "--events-file=", 14) == 0) {
+            events_path = arg + 14;
+        } else if (strncmp(arg, "--seed=", 7) == 0) {
+            cfg.seed = rc.seed = strtoull(arg + 7, NULL, 10);
+        } else if (strcmp(arg, "--metrics") == 0) {
+            metrics = 1;
+        } else if (strcmp(arg, "--pipeline") == 0) {
+            pipeline = 1;
+        } else if (strcmp(arg, "--stream") == 0) {
+            stream = 1;
+        } else if (strncmp(arg, "--lateness=", 11) == 0) {
+            sc.lateness = atoi(arg + 11);
+            if (sc.lateness < 0) {
+                fprintf(stderr, "Error: --lateness must be non-negative\n");
+                return 1;
+            }
+        } else if (strncmp(arg, "--reorder-buffer=", 17) == 0) {
+            long v = atol(arg + 17);
+            if (v < 1) {
+                fprintf(stderr, "Error: --reorder-buffer must be at least 1\n");
+                return 1;
+            }
+            sc.reorder_limit = (size_t)v;
+        } else if (strncmp(arg, "--replications=", 15) == 0) {
+            rc.max_reps = strtoul(arg + 15, NULL, 10);
+            replicate = 1;
+        } else if (strncmp(arg, "--min-replications=", 19) == 0) {
+            rc.min_reps = strtoul(arg + 19, NULL, 10);
+        } else if (strncmp(arg, "--ci=", 5) == 0) {
+            rc.rel_ci = atof(arg + 5);
+        } else if (strncmp(arg, "--threads=", 10) == 0) {
+            rc.threads = atoi(arg + 10);
+        } else {
+            usage(argv[0]);
+            return strcmp(arg, "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    if (stream && (replicate || pipeline)) {
+        fprintf(stderr, "Error: --stream cannot be combined with --replications or --pipeline\n");
+        return 1;
+    }
+    if (replicate && (metrics || pipeline)) {
+        fprintf(stderr, "Error: --replications cannot be combined with --metrics or --pipeline\n");
+        return 1;
+    }
+    if (cfg.events != SIM_EVENTS_NONE) {
+        if (replicate || metrics || pipeline) {
+            fprintf(stderr, "Error: --events cannot be combined with --replications, --metrics or --pipeline\n");
+            return 1;
+        }
+        FILE* f = events_path ? fopen(events_path, "wb") : NULL;
+        if (events_path && !f) {
+            fprintf(stderr, "Error: cannot open '%s' for writing\n", events_path);
+            return 1;
+        }
+        cfg.events_out = f;
+        if (stream) run_stream_with(&cfg, &sc, 0);
+        else        run_simulation_with(&cfg);
+        if (f && fclose(f) != 0) {
+            fprintf(stderr, "Error: failed to write '%s'\n", events_path);
+            return 1;
+        }
+        return 0;
+    }
+    if (replicate) {
+        if (rc.max_reps < 1 || rc.rel_ci < 0) {
+            fprintf(stderr, "Error: --replications must be at least 1 and --ci non-negative\n");
+            return 1;
+        }
+        if (rc.min_reps > rc.max_reps) rc.min_reps = rc.max_reps;
+        run_replications_with(&cfg, &rc);
+        return 0;
+    }
+    if (stream) {
+        run_stream_with(&cfg, &sc, metrics);
+        return 0;
+    }
+    if (pipeline) {
+        run_pipeline_with(&cfg, metrics);
+        return 0;
+    }
+    if (metrics) {
+        run_metrics_with(&cfg);
+        return 0;
+    }
+    run_simulation_with(&cfg);
     return 0;
 }
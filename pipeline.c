@@ -0,0 +1,251 @@
+/*
+ * Конвейерный режим: отдельный поток читает stdin порциями (trace_reader_t),
+ * разбирает их и передаёт записи через кольцевой буфер spsc_ring потоку
+ * симуляции, который начинает цикл событий, не дожидаясь конца входа.
+ * До запуска потока читается только заголовок N (он нужен для создания
+ * прогона), поэтому и чтение, и разбор идут параллельно с циклом событий.
+ * Буфер чтения переиспользуется, так что id едут в кольце внутри записи,
+ * а поток симуляции складывает их в свой tr->data.
+ *
+ * Цикл событий требует записей по неубыванию ta. Если вход оказался
+ * неотсортированным, прогон прерывается, остаток дочитывается,
+ * и симуляция повторяется обычным путём с сортировкой.
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "queue.h"
+#include "spsc_ring.h"
+#include "trace.h"
+
+#define PIPE_BATCH 4096        // записей в одной пачке разбора и чтения
+#define PIPE_RING  (1 << 16)   // ёмкость кольца в записях
+
+/* Запись в кольце: id копируется, буфер чтения к приходу записи уже другой */
+typedef struct {
+    int           ta;
+    int           ts;
+    unsigned char id_len;
+    char          id[MAX_ID_LEN];
+} pipe_rec_t;
+
+typedef struct {
+    trace_reader_t rd;
+    trace_t        view;        // целые токены текущей порции
+    trace_cursor_t cur;
+    spsc_ring_t*   ring;
+    pipe_rec_t*    out;         // пачка потока разбора
+    pipe_rec_t*    recs;        // пачка потока симуляции
+    size_t         data_cap;    // ёмкость tr->data
+    int            last_ta;
+    int            unsorted;    // встретилась запись раньше предыдущей
+    int            oom;
+    int            read_error;  // ошибка чтения в потоке разбора
+} pipeline_t;
+
+/*
+ * Разбирает до max записей из текущей порции в out; когда порция
+ * кончилась, дочитывает следующую. 0 — вход кончился (или ошибка чтения).
+ */
+static size_t pipeline_parse(pipeline_t* pl, pipe_rec_t* out, size_t max) {
+    passenger_t batch[256];
+    size_t n = 0;
+    while (n < max) {
+        size_t want = max - n < 256 ? max - n : 256;
+        size_t got = trace_parse_batch(&pl->view, &pl->cur, batch, want);
+        for (size_t i = 0; i < got; i++) {
+            pipe_rec_t* r = &out[n + i];
+            r->ta = batch[i].ta;
+            r->ts = batch[i].ts;
+            r->id_len = (unsigned char)batch[i].id_len;
+            memcpy(r->id, trace_id(&pl->view, &batch[i]), (size_t)batch[i].id_len);
+        }
+        n += got;
+        if (got == want) continue;
+        // Порция разобрана: следующая (после конца входа view — уже весь остаток)
+        if (pl->rd.eof) break;
+        if (trace_reader_next(&pl->rd, &pl->view, &pl->cur) < 0) {
+            pl->read_error = 1;
+            break;
+        }
+    }
+    return n;
+}
+
+/* Поток разбора: порции stdin в кольцо */
+static void* pipeline_producer(void* arg) {
+    pipeline_t* pl = arg;
+    size_t n;
+    while ((n = pipeline_parse(pl, pl->out, PIPE_BATCH)) > 0) spsc_ring_push(pl->ring, pl->out, n);
+    spsc_ring_close(pl->ring);
+    return NULL;
+}
+
+/* Дописывает n записей в tr (id — в tr->data). 0 или -1 при ошибке malloc */
+static int pipeline_append(pipeline_t* pl, trace_t* tr, const pipe_rec_t* recs, size_t n) {
+    size_t chars = 0;
+    for (size_t i = 0; i < n; i++) chars += recs[i].id_len;
+    if (trace_reserve(tr, n) < 0) return -1;
+    if (tr->size + chars > pl->data_cap) {
+        size_t cap = pl->data_cap ? pl->data_cap : PIPE_BATCH * 16;
+        while (cap < tr->size + chars) cap *= 2;
+        char* tmp = realloc(tr->data, cap);
+        if (!tmp) return -1;
+        tr->data = tmp;
+        pl->data_cap = cap;
+    }
+    for (size_t i = 0; i < n; i++) {
+        passenger_t* p = &tr->items[tr->count++];
+        p->id_off = tr->size;
+        p->id_len = recs[i].id_len;
+        p->ta = recs[i].ta;
+        p->ts = recs[i].ts;
+        memcpy(tr->data + tr->size, recs[i].id, recs[i].id_len);
+        tr->size += recs[i].id_len;
+        if (p->ta < pl->last_ta) pl->unsorted = 1;
+        pl->last_ta = p->ta;
+    }
+    return 0;
+}
+
+/* Забирает из кольца следующую пачку в tr. 1, 0 (конец) или -1 при ошибке malloc */
+static int pipeline_take(pipeline_t* pl, trace_t* tr) {
+    size_t n = spsc_ring_pop(pl->ring, pl->recs, PIPE_BATCH);
+    if (n == 0) return 0;
+    if (pipeline_append(pl, tr, pl->recs, n) < 0) {
+        pl->oom = 1;
+        return -1;
+    }
+    return 1;
+}
+
+/* Освобождает буферы конвейера (кольцо и чтение) */
+static void pipeline_free(pipeline_t* pl) {
+    spsc_ring_destroy(pl->ring);
+    trace_reader_close(&pl->rd);
+    free(pl->out);
+    free(pl->recs);
+}
+
+/* sim_feed_fn: следующая пачка для цикла событий */
+static int pipeline_feed(trace_t* tr, void* ctx) {
+    pipeline_t* pl = ctx;
+    int rc = pipeline_take(pl, tr);
+    if (rc > 0 && pl->unsorted) return -1;
+    return rc;
+}
+
+/* Дочитывает кольцо до конца: в tr или, если памяти нет, впустую */
+static void pipeline_drain(pipeline_t* pl, trace_t* tr) {
+    while (!pl->oom && pipeline_take(pl, tr) > 0) {}
+    if (pl->oom) {
+        while (spsc_ring_pop(pl->ring, pl->recs, PIPE_BATCH) > 0) {}
+    }
+}
+
+void run_pipeline_with(const sim_config_t* cfg, int metrics_only) {
+    pipeline_t pl;
+    memset(&pl, 0, sizeof(pl));
+    trace_t tr;
+    trace_init_buffer(&tr, NULL, 0);
+    tr.owned = 1;  // tr->data растёт в pipeline_append
+    pl.out = malloc(PIPE_BATCH * sizeof(pipe_rec_t));
+    pl.recs = malloc(PIPE_BATCH * sizeof(pipe_rec_t));
+    if (!pl.out || !pl.recs || trace_reader_open(&pl.rd, stdin) < 0) {
+        fprintf(stderr, "Error: malloc failed for input buffer\n");
+        pipeline_free(&pl);
+        return;
+    }
+    int hrc = trace_reader_header(&pl.rd, &pl.view, &pl.cur);
+    if (hrc < 0) {
+        fprintf(stderr, hrc == -1 ? "Error: failed to read number of desks\n" : "Error: failed to read input\n");
+        pipeline_free(&pl);
+        return;
+    }
+    tr.desks = pl.view.desks;
+    if (tr.desks < 2) {
+        fprintf(stderr, "Error: at least 2 desks are required, but N=%d\n", tr.desks);
+        pipeline_free(&pl);
+        return;
+    }
+
+    sim_metrics_t metrics;
+    sim_config_t run_cfg = *cfg;
+    // Прогон может повториться с сортировкой, поэтому блоки таблицы печатаются после него
+    run_cfg.table_out = NULL;
+    if (metrics_only) {
+        if (sim_metrics_init(&metrics, tr.desks) < 0) {
+            fprintf(stderr, "Error: malloc failed for metrics\n");
+            pipeline_free(&pl);
+            return;
+        }
+        run_cfg.metrics = &metrics;
+    }
+
+    pl.ring = spsc_ring_create(PIPE_RING, sizeof(pipe_rec_t));
+    pthread_t producer;
+    int threaded = pl.ring && pthread_create(&producer, NULL, pipeline_producer, &pl) == 0;
+
+    sim_table_t* table = NULL;
+    sim_stats_t stats;
+    int rc;
+    pl.last_ta = -2147483647 - 1;
+    if (threaded) {
+        rc = sim_run_feed(&tr, &run_cfg, pipeline_feed, &pl, metrics_only ? NULL : &table, &stats);
+        pipeline_drain(&pl, &tr);
+        pthread_join(producer, NULL);
+    } else {
+        // Потоки недоступны — читаем и разбираем всё в этом
+        size_t n;
+        while (!pl.oom && (n = pipeline_parse(&pl, pl.out, PIPE_BATCH)) > 0) {
+            if (pipeline_append(&pl, &tr, pl.out, n) < 0) pl.oom = 1;
+        }
+        pl.unsorted = 1;  // порядок не проверялся — сортируем
+        rc = -2;
+    }
+    tr.skipped += pl.cur.skipped;
+    pipeline_free(&pl);
+
+    if (pl.oom || pl.read_error) {
+        if (pl.read_error) fprintf(stderr, "Error: failed to read input\n");
+        else               fprintf(stderr, "Error: out of memory after reading %zu passengers\n", tr.count);
+        if (metrics_only) sim_metrics_free(&metrics);
+        sim_table_free(table);
+        trace_free(&tr);
+        return;
+    }
+    if (tr.skipped) {
+        fprintf(stderr, "Warning: skipped %zu malformed records (expected id/ta/ts)\n", tr.skipped);
+    }
+    if (rc == -2 && pl.unsorted) {
+        // Вход не отсортирован: повторяем прогон с начала по отсортированной трассе
+        if (threaded) {
+            fprintf(stderr, "Warning: input is not sorted by arrival time, pipelining disabled\n");
+        }
+        if (metrics_only) {
+            sim_metrics_free(&metrics);
+            if (sim_metrics_init(&metrics, tr.desks) < 0) {
+                fprintf(stderr, "Error: malloc failed for metrics\n");
+                trace_free(&tr);
+                return;
+            }
+        }
+        trace_sort(&tr);
+        rc = sim_run(&tr, &run_cfg, metrics_only ? NULL : &table, &stats);
+    }
+
+    if (rc == 0) {
+        if (stats.rejected) {
+            fprintf(stderr, "Warning: %zu passengers were rejected by full desk queues\n", stats.rejected);
+        }
+        if (metrics_only) {
+            sim_metrics_print(&metrics, stdout);
+        } else {
+            sim_table_print(table, stdout);
+            sim_table_free(table);
+        }
+    }
+    if (metrics_only) sim_metrics_free(&metrics);
+    trace_free(&tr);
+}
@@ -2,35 +2,98 @@
 #define QUEUE_H
 
 #include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "hist.h"
+#include "trace.h"
 
 #define MAX_ID_LEN 32
 
 /* Непрозрачный тип очереди, т.е. объявляю тип queue_t, не раскрывая его структуру.
-* Поля array_queue_t и list_queue_t опрелены в queue.calloс
+* Структуры реализаций (list_queue_t, array_queue_t) определены в своих .c файлах.
 * При этом код, который подключает queue.h, видит лишь указатель queue_t* и может вызывать
 * функции queue_create, queue_enqueue и т. д., но не знает, как устроена сама структура queue.
 */
 typedef struct queue queue_t;
 
 /*
- * Создаёт новую очередь.
- * - Если при компиляции указан флаг -DUSE_ARRAY_QUEUE, будет использоваться
- *   кольцевой буфер фиксированной ёмкости = capacity.
- * - Иначе — односвязная версия, без переполнения.
- * Возвращает NULL при ошибке malloc/инициализации.
+ * Пул памяти для записей очередей: узлы берутся из больших блоков и
+ * возвращаются в список свободных, так что в установившемся режиме
+ * enqueue/dequeue не обращаются к malloc/free. Один пул можно отдать
+ * нескольким очередям (например, всем стойкам одной симуляции).
+ * Пул не потокобезопасен: его очереди используются из одного потока.
+ */
+typedef struct queue_pool queue_pool_t;
+
+/* Создаёт пустой пул. NULL при ошибке malloc. */
+queue_pool_t* queue_pool_create(void);
+
+/*
+ * Освобождает пул со всей его памятью. Очереди, созданные на нём,
+ * к этому моменту должны быть уничтожены.
+ */
+void queue_pool_destroy(queue_pool_t* pool);
+
+/*
+ * Реализации очереди. Все они собраны в библиотеку одновременно,
+ * поэтому выбирать можно при создании каждой очереди, без пересборки.
+ */
+typedef enum {
+    QUEUE_BACKEND_LIST,   // односвязный список, без переполнения
+    QUEUE_BACKEND_ARRAY,  // кольцевой буфер фиксированной ёмкости
+    QUEUE_BACKEND_RING,   // растущий кольцевой буфер (степень двойки), id внутри записей
+    QUEUE_BACKEND_CHUNK,  // связанные блоки по 64 записи из общего пула
+    QUEUE_BACKEND_COUNT
+} queue_backend_t;
+
+/*
+ * Создаёт новую очередь с реализацией backend.
+ * capacity — ёмкость для кольцевого буфера array; остальные реализации
+ * растут сами и её игнорируют.
+ * Возвращает NULL при ошибке malloc/инициализации или неизвестной реализации.
+ */
+queue_t* queue_create_with(queue_backend_t backend, size_t capacity);
+
+/*
+ * То же, что queue_create_with, но записи берутся из общего пула pool.
+ * pool == NULL — у очереди свой пул. Пул используют list (узлы) и chunk
+ * (блоки записей); кольцевые буферы array и ring его не трогают.
+ */
+queue_t* queue_create_pooled(queue_backend_t backend, size_t capacity, queue_pool_t* pool);
+
+/*
+ * Создаёт новую очередь с реализацией по умолчанию (queue_default_backend()).
  */
 queue_t* queue_create(size_t capacity);
 
+/*
+ * Реализация по умолчанию: кольцевой буфер, если библиотека собрана
+ * с -DUSE_ARRAY_QUEUE, иначе — односвязный список.
+ */
+queue_backend_t queue_default_backend(void);
+
+/* Короткое имя реализации ("list", "array", "ring", "chunk") или NULL для неизвестной. */
+const char* queue_backend_name(queue_backend_t backend);
+
+/* Ищет реализацию по имени. Возвращает 0 и пишет её в *out, либо -1. */
+int queue_backend_from_name(const char* name, queue_backend_t* out);
+
 /** Освобождает все ресурсы очереди, включая строки с id. */
 void queue_destroy(queue_t* q);
 
 /*
  * Добавляет в конец очереди пассажира с идентификатором passenger_id
- * и временем обслуживания service_time.
- * Возвращает 0 при успехе, -1 при ошибке (переполнение/malloc).
+ * (не длиннее MAX_ID_LEN - 1) и временем обслуживания service_time.
+ * Возвращает 0 при успехе, -1 при ошибке (переполнение/malloc/длинный id).
  */
 int queue_enqueue(queue_t* q, const char* passenger_id, int service_time);
 
+/*
+ * То же, что queue_enqueue, но id задан срезом passenger_id[0..id_len-1]
+ * и не обязан завершаться '\0' (например, id прямо из буфера входа).
+ */
+int queue_enqueue_n(queue_t* q, const char* passenger_id, size_t id_len, int service_time);
+
 /*
  * Возвращает указатель на строку с id первого пассажира (или NULL, если пусто).
  * Строку нельзя освобождать извне — она принадлежит очереди.
@@ -61,6 +124,294 @@ size_t queue_size(const queue_t* q);
  */
 size_t queue_dump_ids(const queue_t* q, char out[][MAX_ID_LEN]);
 
+/* Пассажир для пакетной постановки: срез id и время обслуживания */
+typedef struct {
+    const char* id;
+    size_t      id_len;
+    int         service_time;
+} queue_item_t;
+
+/*
+ * Ставит в очередь items[0..n-1] по порядку — как n вызовов queue_enqueue_n,
+ * но за один вызов. Останавливается на первой неудаче.
+ * Возвращает число поставленных пассажиров.
+ */
+size_t queue_enqueue_bulk(queue_t* q, const queue_item_t* items, size_t n);
+
+/* Удаляет до n первых пассажиров. Возвращает число удалённых. */
+size_t queue_dequeue_bulk(queue_t* q, size_t n);
+
+/*
+ * Обход очереди от первого пассажира без копирования: для каждого вызывает
+ * visit(id, id_len, service_time, ctx). id принадлежит очереди и завершён '\0';
+ * действителен до следующего изменения очереди. Ненулевой ответ visit
+ * прекращает обход. Очередь во время обхода менять нельзя.
+ */
+typedef int (*queue_visit_fn)(const char* id, size_t id_len, int service_time, void* ctx);
+
+/* Возвращает число посещённых пассажиров. */
+size_t queue_foreach(const queue_t* q, queue_visit_fn visit, void* ctx);
+
+/* Политика выбора стойки для пришедшего пассажира */
+typedef enum {
+    SIM_POLICY_POWER_OF_D,   // d случайных разных стоек, из них самая короткая очередь
+    SIM_POLICY_JSQ,          // самая короткая очередь среди всех стоек
+    SIM_POLICY_LEAST_WORK,   // наименьшая оставшаяся работа (сумма времён обслуживания)
+    SIM_POLICY_ROUND_ROBIN,  // стойки по кругу
+    SIM_POLICY_COUNT
+} sim_policy_t;
+
+/* Имя политики ("power-of-d", "jsq", "least-work", "round-robin") или NULL. */
+const char* sim_policy_name(sim_policy_t policy);
+
+/* Ищет политику по имени. Возвращает 0 и пишет её в *out, либо -1. */
+int sim_policy_from_name(const char* name, sim_policy_t* out);
+
+/* Что делать с пассажиром, если выбранная стойка заполнена (sim_config_t.queue_limit) */
+typedef enum {
+    SIM_OVERFLOW_REJECT,        // отказать (счётчик rejected)
+    SIM_OVERFLOW_REDIRECT,      // к самой короткой очереди, если в ней есть место, иначе отказ
+    SIM_OVERFLOW_SPILL,         // в общую очередь ожидания; её забирают стойки по мере
+                                // освобождения места; если и она полна — отказ
+    SIM_OVERFLOW_BACKPRESSURE,  // придержать приходы: пассажир и все следующие ждут,
+                                // пока какая-нибудь стойка не освободит место
+    SIM_OVERFLOW_COUNT
+} sim_overflow_t;
+
+/* Имя ("reject", "redirect", "spill", "backpressure") или NULL. */
+const char* sim_overflow_name(sim_overflow_t overflow);
+
+/* Ищет политику переполнения по имени. Возвращает 0 и пишет её в *out, либо -1. */
+int sim_overflow_from_name(const char* name, sim_overflow_t* out);
+
+/*
+ * Журнал событий (sim_config_t.events): по записи на событие прямо по ходу
+ * прогона — момент, стойка (с 1, как в таблице), вид события, id пассажира
+ * и длина очереди стойки после события. Память постоянная, запись идёт
+ * через буфер крупными блоками.
+ * - csv:    заголовок "time,desk,event,id,queue", далее строки "5,2,arrival,p17,3"
+ * - jsonl:  {"time":5,"desk":2,"event":"arrival","id":"p17","queue":3}
+ * - binary: 8 байт "QEVLOG1\0", затем записи little-endian:
+ *           int32 time, uint32 desk, uint32 queue, uint8 event, uint8 id_len, id
+ *           (event: 0 — arrival, 1 — departure, 2 — reject)
+ */
+typedef enum {
+    SIM_EVENTS_NONE,
+    SIM_EVENTS_CSV,
+    SIM_EVENTS_JSONL,
+    SIM_EVENTS_BINARY,
+    SIM_EVENTS_COUNT
+} sim_events_format_t;
+
+/* Вид события журнала */
+typedef enum {
+    SIM_EVENT_ARRIVAL,    // пассажир встал в очередь стойки
+    SIM_EVENT_DEPARTURE,  // пассажир обслужен и ушёл
+    SIM_EVENT_REJECT,     // стойка заполнена, пассажиру отказано
+} sim_event_kind_t;
+
+/* Событие прогона для sim_config_t.on_event */
+typedef struct {
+    int              time;
+    int              desk;    // номер стойки с 0
+    sim_event_kind_t kind;
+    const char*      id;      // id пассажира (не завершён '\0')
+    size_t           id_len;
+    size_t           queue;   // длина очереди стойки после события
+} sim_event_t;
+
+typedef void (*sim_event_fn)(const sim_event_t* ev, void* ctx);
+
+/* Имя ("none", "csv", "jsonl", "binary") или NULL. */
+const char* sim_events_format_name(sim_events_format_t format);
+
+/* Ищет формат журнала событий по имени. Возвращает 0 и пишет его в *out, либо -1. */
+int sim_events_format_from_name(const char* name, sim_events_format_t* out);
+
+/*
+ * Задержки и загрузка за прогон. Ожидание (от прихода до начала обслуживания)
+ * и время пребывания (ожидание + обслуживание) записываются в момент, когда
+ * пассажир доходит до начала очереди; память постоянная, кроме busy[N].
+ */
+typedef struct {
+    hist_t   wait;
+    hist_t   sojourn;
+    int      N;
+    int64_t* busy;           // суммарное время обслуживания на стойке
+    int      first_arrival;  // момент первого прихода
+    int      makespan;       // момент последнего ухода
+    size_t   rejected;
+    // Ограничение очередей и политика переполнения прогона (queue_limit 0 — без ограничения)
+    size_t         queue_limit;
+    sim_overflow_t overflow;
+    size_t         redirected;  // отправлено к другой стойке
+    size_t         spilled;     // прошло через общую очередь ожидания
+    size_t         held;        // придержано на входе
+} sim_metrics_t;
+
+/* Готовит метрики для N стоек. 0 или -1 при ошибке malloc. */
+int sim_metrics_init(sim_metrics_t* m, int N);
+
+void sim_metrics_free(sim_metrics_t* m);
+
+/* Загрузка стойки d: доля [first_arrival, makespan], занятая обслуживанием */
+double sim_metrics_utilization(const sim_metrics_t* m, int d);
+
+/* Печатает сводку: квантили ожидания и пребывания, загрузку стоек. */
+void sim_metrics_print(const sim_metrics_t* m, FILE* out);
+
+/*
+ * Параметры симуляции. Перед заполнением вызывайте sim_config_init —
+ * она выставляет значения по умолчанию для всех полей.
+ */
+typedef struct {
+    queue_backend_t backend;  // реализация очередей стоек
+    int             profile;  // 1 — замерять время записи снимков (sim_stats_t.snapshot_sec)
+    uint64_t        seed;     // зерно генератора выбора стоек (по умолчанию 1)
+    sim_policy_t    policy;   // политика выбора стойки (по умолчанию power-of-d)
+    int             choices;  // d для power-of-d (по умолчанию 2, не больше N и 64)
+    sim_metrics_t*  metrics;  // куда собирать задержки (NULL — не собирать);
+                              // sim_metrics_init с тем же N, что у трассы
+    size_t          queue_limit;  // наибольшая длина очереди стойки; 0 — без ограничения
+                                  // (у array — её ёмкость, 1000)
+    sim_overflow_t  overflow;     // что делать при заполненной стойке (по умолчанию reject)
+    size_t          spill_limit;  // ёмкость общей очереди для spill (0 — как queue_limit)
+    size_t          table_block;  // столбцов в блоке таблицы (0 — таблица одним блоком)
+    FILE*           table_out;    // при table_block: куда печатать блоки по ходу прогона
+                                  // (NULL — все блоки печатает sim_table_print)
+    sim_events_format_t events;   // журнал событий (по умолчанию нет)
+    FILE*           events_out;   // куда писать журнал (NULL — stdout)
+    sim_event_fn    on_event;     // вызывается на каждое событие (NULL — нет)
+    void*           event_ctx;    // второй аргумент on_event
+    int             table;        // sim_create: записывать снимки для sim_get_table
+} sim_config_t;
+
+void sim_config_init(sim_config_t* cfg);
+
+/*
+ * Результат прогона: моменты времени и снимки очередей для табличного вывода.
+ * Ссылается на записи трассы, поэтому трасса должна жить дольше таблицы.
+ */
+typedef struct sim_table sim_table_t;
+
+/* Счётчики и замеры одного прогона sim_run. */
+typedef struct {
+    double loop_sec;      // время цикла событий целиком
+    double snapshot_sec;  // из него — запись снимков (только при cfg->profile)
+    size_t arrivals;      // обработано приходов
+    size_t departures;    // обработано уходов
+    size_t columns;       // сохранено моментов времени (столбцов таблицы)
+    size_t rejected;      // пассажиров не приняла полная стойка
+    size_t redirected;    // отправлено к другой стойке (overflow redirect)
+    size_t spilled;       // прошло через общую очередь ожидания (overflow spill)
+    size_t held;          // придержано на входе (overflow backpressure)
+    size_t max_spill;     // наибольшая длина общей очереди ожидания
+    double mean_wait;     // среднее ожидание до начала обслуживания
+    int    max_wait;      // наибольшее ожидание
+    size_t max_queue;     // наибольшая длина очереди стойки
+    int    makespan;      // момент последнего ухода
+} sim_stats_t;
+
+/*
+ * Моделирует распределение пассажиров по стойкам политикой cfg->policy
+ * (по умолчанию Power of Two Choices) над разобранной трассой tr, которая уже
+ * отсортирована по ta (trace_sort). Трасса не меняется и может читаться
+ * из нескольких потоков одновременно: у каждого прогона свой генератор.
+ * Одинаковые tr и cfg (включая cfg->seed) дают одинаковый результат.
+ * При успехе возвращает 0 и таблицу в *table (освобождать sim_table_free),
+ * при ошибке печатает сообщение в stderr и возвращает -1.
+ * table == NULL — снимки не пишутся, считаются только stats.
+ * stats может быть NULL.
+ */
+int sim_run(const trace_t* tr, const sim_config_t* cfg, sim_table_t** table, sim_stats_t* stats);
+
+/*
+ * Источник записей для sim_run_feed. Вызывается, когда все записи tr->items
+ * обработаны: должен дописать в tr следующие (trace_reserve + tr->count)
+ * и вернуть 1, вернуть 0, если записей больше не будет, или -1, чтобы
+ * прервать прогон. Записи должны идти по неубыванию ta.
+ */
+typedef int (*sim_feed_fn)(trace_t* tr, void* ctx);
+
+/*
+ * То же, что sim_run, но записи поступают порциями от feed по ходу прогона
+ * (tr->items может перевыделяться между вызовами feed). Возвращает 0,
+ * -1 при ошибке (сообщение в stderr) или -2, если feed прервал прогон.
+ */
+int sim_run_feed(trace_t* tr, const sim_config_t* cfg, sim_feed_fn feed, void* feed_ctx,
+                 sim_table_t** table, sim_stats_t* stats);
+
+/*
+ * Пошаговый прогон для встраивания: пассажиры добавляются по одному,
+ * время продвигается явно, состояние стоек читается между шагами.
+ * sim_run построен на нём же.
+ *
+ *     sim_t* s = sim_create(&cfg, N);
+ *     sim_add_arrival(s, "p1", 2, 0, 5);   // приходы — по неубыванию ta
+ *     sim_advance_until(s, 3);             // события с моментом <= 3
+ *     sim_query_desk(s, 0, &state);
+ *     sim_drain(s);                        // до обслуживания всех
+ *     sim_destroy(s);
+ *
+ * События уходят в cfg->on_event (и в журнал cfg->events) по мере обработки.
+ * Без таблицы память не растёт с числом пассажиров: обслуженные записи
+ * выбрасываются.
+ */
+typedef struct sim sim_t;
+
+/* Состояние стойки между шагами прогона (sim_query_desk) */
+typedef struct {
+    size_t      queue;         // пассажиров у стойки, включая обслуживаемого
+    size_t      served;        // обслужено с начала прогона
+    int         busy_until;    // момент конца текущего обслуживания; -1 — стойка свободна
+    const char* front_id;      // id обслуживаемого (с '\0') или NULL; до следующего шага
+    size_t      front_id_len;
+} sim_desk_state_t;
+
+/* Создаёт пустой прогон на desks стоек. NULL при ошибке (сообщение в stderr). */
+sim_t* sim_create(const sim_config_t* cfg, int desks);
+
+/*
+ * Добавляет пассажира id[0..id_len-1] с приходом ta и обслуживанием ts.
+ * ta не меньше, чем у предыдущего, и больше момента, до которого прогон
+ * уже продвинут. Возвращает 0 или -1 (сообщение в stderr).
+ */
+int sim_add_arrival(sim_t* sim, const char* id, size_t id_len, int ta, int ts);
+
+/*
+ * Обрабатывает все события с моментом не позже t. Приходы с ta <= t
+ * должны быть добавлены заранее. 0 или -1 при ошибке (прогон дальше не идёт).
+ */
+int sim_advance_until(sim_t* sim, int t);
+
+/* Обрабатывает все оставшиеся события. Новые приходы — позже sim_now. */
+int sim_drain(sim_t* sim);
+
+/* Момент последнего обработанного события */
+int sim_now(const sim_t* sim);
+
+/* Состояние стойки desk (с 0) в *out. 0 или -1, если такой стойки нет. */
+int sim_query_desk(const sim_t* sim, int desk, sim_desk_state_t* out);
+
+/* Счётчики прогона на текущий момент */
+void sim_get_stats(const sim_t* sim, sim_stats_t* stats);
+
+/* Таблица снимков (при cfg->table) или NULL; живёт до sim_destroy. */
+const sim_table_t* sim_get_table(const sim_t* sim);
+
+/* Освобождает прогон; итоги дописываются в cfg->metrics, журнал событий сбрасывается. */
+void sim_destroy(sim_t* sim);
+
+/*
+ * Печатает таблицу «момент времени × стойка» в поток out: блоками по
+ * cfg->table_block столбцов через пустую строку, у каждого блока своя
+ * ширина столбца. Блоки, уже напечатанные в cfg->table_out по ходу
+ * прогона, не повторяются.
+ */
+void sim_table_print(const sim_table_t* table, FILE* out);
+
+void sim_table_free(sim_table_t* table);
+
 /*
  * Запускает всю симуляцию:
  * - Читает из stdin сначала целое N (число стоек),
@@ -70,4 +421,92 @@ size_t queue_dump_ids(const queue_t* q, char out[][MAX_ID_LEN]);
  */
 void run_simulation(void);
 
+/*
+ * То же, что run_simulation, но с явными параметрами cfg.
+ * При cfg->events вместо таблицы пишется только журнал событий.
+ */
+void run_simulation_with(const sim_config_t* cfg);
+
+/*
+ * Серия независимых прогонов (репликаций) над одной трассой: прогон k идёт
+ * со своим зерном, прогоны раздаются пулу потоков. Итоги собираются
+ * в порядке номеров прогонов, поэтому результат не зависит от числа потоков.
+ */
+typedef struct {
+    size_t   min_reps;  // не меньше стольких прогонов
+    size_t   max_reps;  // и не больше стольких
+    double   rel_ci;    // остановиться, когда полуширина 95% ДИ среднего ожидания
+                        // не больше rel_ci * среднее (0 — всегда max_reps прогонов)
+    int      threads;   // 0 — по числу процессоров
+    uint64_t seed;      // базовое зерно, из него выводятся зёрна прогонов
+} sim_replicate_config_t;
+
+void sim_replicate_config_init(sim_replicate_config_t* rc);
+
+/* Сводка одной метрики по прогонам */
+typedef struct {
+    double mean;
+    double half_width;  // полуширина 95% доверительного интервала среднего
+    double min;
+    double max;
+} sim_metric_summary_t;
+
+typedef struct {
+    size_t               reps;       // учтено прогонов
+    int                  threads;
+    int                  converged;  // достигнута ли точность rel_ci
+    double               wall_sec;
+    sim_metric_summary_t mean_wait;
+    sim_metric_summary_t max_wait;
+    sim_metric_summary_t max_queue;
+    sim_metric_summary_t makespan;
+} sim_replicate_result_t;
+
+/*
+ * Выполняет серию прогонов sim_run (без таблиц) над отсортированной трассой tr.
+ * Возвращает 0 и сводку в *res, либо -1 при ошибке (сообщение в stderr).
+ */
+int sim_replicate(const trace_t* tr, const sim_config_t* cfg,
+                  const sim_replicate_config_t* rc, sim_replicate_result_t* res);
+
+/* Печатает сводку серии прогонов в поток out. */
+void sim_replicate_print(const sim_replicate_result_t* res, FILE* out);
+
+/* Читает вход из stdin, как run_simulation, и печатает только сводку sim_metrics_print. */
+void run_metrics_with(const sim_config_t* cfg);
+
+/*
+ * Как run_simulation_with (или run_metrics_with при metrics_only), но разбор
+ * входа идёт в отдельном потоке параллельно с циклом событий. Выигрыш — на
+ * отсортированных по ta входах; неотсортированный вход обрабатывается
+ * обычным путём после предупреждения.
+ */
+void run_pipeline_with(const sim_config_t* cfg, int metrics_only);
+
+/*
+ * Потоковый режим: записи читаются из stdin по мере поступления (например,
+ * из канала от живого источника) и идут в sim_t без сортировки всей трассы.
+ * Пришедшие не по порядку записи ждут в ограниченной куче по ta.
+ * Водяной знак — наибольший увиденный ta минус lateness: всё, что раньше
+ * него, отпускается в прогон, и прогон продвигается до него.
+ * Запись, пришедшая позже водяного знака, отбрасывается (с предупреждением).
+ * Если куча заполнена, раньше срока отпускается самая ранняя запись.
+ */
+typedef struct {
+    int    lateness;       // насколько ta может отставать от наибольшего увиденного
+    size_t reorder_limit;  // записей в куче ожидания, не больше
+} sim_stream_config_t;
+
+void sim_stream_config_init(sim_stream_config_t* sc);
+
+/*
+ * Как run_simulation_with (или run_metrics_with при metrics_only), но в
+ * потоковом режиме. Таблицу имеет смысл печатать блоками (table_block):
+ * тогда блоки выходят по ходу, а память не растёт с длиной входа.
+ */
+void run_stream_with(const sim_config_t* cfg, const sim_stream_config_t* sc, int metrics_only);
+
+/* Читает вход из stdin, как run_simulation, и печатает сводку серии прогонов. */
+void run_replications_with(const sim_config_t* cfg, const sim_replicate_config_t* rc);
+
 #endif // QUEUE_H
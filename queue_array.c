@@ -1,99 +1,58 @@
 #include <stdlib.h>
 #include <string.h>
-#include "queue.h"
-
-#ifdef USE_ARRAY_QUEUE
+#include "queue_impl.h"
 
 /**
- * Очередь на основе кольцевого буфера с буфером отказанных пассажиров.
+ * Очередь на основе кольцевого буфера фиксированной ёмкости.
+ * Когда буфер полон, enqueue отказывает (-1) и ничего не хранит:
+ * что делать с пассажиром, решает вызывающий (см. sim_overflow_t).
  */
 typedef struct {
-    char**  data;       // массив строк-идентификаторов пассажиров
-    int*    times;      // массив времен обслуживания пассажиров
-    size_t  capacity;   // максимальная ёмкость буфера
-    size_t  head;       // индекс первого элемента в буфере
-    size_t  tail;       // индекс для следующего элемента
-    size_t  size;       // текущее число элементов
-
-    char**  dropped;    // массив ID пассажиров, не поместившихся в очередь
-    size_t  drop_size;  // число отказанных пассажиров
-    size_t  drop_cap;   // ёмкость массива dropped
+    queue_t      base;      // общий заголовок очереди (таблица функций)
+    queue_rec_t* recs;      // записи пассажиров (id целиком внутри)
+    size_t       capacity;  // максимальная ёмкость буфера
+    size_t       head;      // индекс первого элемента в буфере
+    size_t       tail;      // индекс для следующего элемента
+    size_t       size;      // текущее число элементов
 } array_queue_t;
 
 /**
- * Инициализация очереди и буфера отказанных
- * - выделяет основной буфер data/times для capacity элементов
- * - создаёт буфер dropped для хранения отказанных пассажиров
+ * Создание очереди: выделяет буфер recs для capacity элементов.
+ * Возвращает NULL при ошибке malloc или нулевой ёмкости.
  */
-static int array_queue_init(array_queue_t* q, size_t capacity) {
-    q->data     = malloc(capacity * sizeof(char*));
-    q->times    = malloc(capacity * sizeof(int));
-    if (!q->data || !q->times) {
-        free(q->data);
-        free(q->times);
-        return -1;
+static queue_t* array_queue_create(size_t capacity, queue_pool_t* pool) {
+    (void)pool;  // память выделяется на всю ёмкость сразу, пул не нужен
+    if (capacity == 0) return NULL;
+    array_queue_t* q = malloc(sizeof(array_queue_t));
+    if (!q) return NULL;
+    q->base.ops = &array_queue_ops;
+    q->recs     = malloc(capacity * sizeof(queue_rec_t));
+    if (!q->recs) {
+        free(q);
+        return NULL;
     }
     q->capacity = capacity;
     q->head = q->tail = q->size = 0;
-
-    q->drop_cap = capacity / 2 + 1;  // начальный размер буфера отказанных
-    q->dropped = malloc(q->drop_cap * sizeof(char*));
-    if (!q->dropped) {
-        free(q->data);
-        free(q->times);
-        return -1;
-    }
-    q->drop_size = 0;
-    return 0;
+    return &q->base;
 }
 
 /**
- * Освобождение ресурсов очереди и буфера отказанных
- * - очищает и освобождает все строки в data и dropped
- * - освобождает сами массивы
+ * Освобождение ресурсов очереди: id лежат в записях, освобождается только буфер
  */
-static void array_queue_destroy(array_queue_t* q) {
-    // основной буфер
-    for (size_t i = 0; i < q->size; i++) {
-        free(q->data[(q->head + i) % q->capacity]);
-    }
-    free(q->data);
-    free(q->times);
-    // буфер отказанных
-    for (size_t i = 0; i < q->drop_size; i++) {
-        free(q->dropped[i]);
-    }
-    free(q->dropped);
+static void array_queue_destroy(queue_t* base) {
+    array_queue_t* q = (array_queue_t*)base;
+    free(q->recs);
+    free(q);
 }
 
 /**
- * Добавление пассажира:
- * - если в основной очереди есть место, копирует ID и ts в data/times
- * - иначе сохраняет копию ID в dropped для последующей обработки
- * Возвращает 0 при успешном enqueue, -1 при переполнении или ошибке malloc.
+ * Добавление пассажира: если есть место, копирует ID и ts в запись recs[tail].
+ * Возвращает 0 при успешном enqueue, -1 при переполнении или слишком длинном id.
  */
-static int array_queue_enqueue(array_queue_t* q, const char* passenger_id, int service_time) {
-    if (q->size == q->capacity) {
-        // основной буфер полон, поэтому сохраняем в dropped
-        if (q->drop_size == q->drop_cap) { // буфер отказанных полон
-            size_t newcap = q->drop_cap * 2; // задаём новую ёмкость, которая в 2 раза больше
-            char** tmp = realloc(q->dropped, newcap * sizeof(char*));
-            if (!tmp) return -1; // 
-            q->dropped = tmp;
-            q->drop_cap = newcap;
-        }
-        q->dropped[q->drop_size] = malloc(strlen(passenger_id) + 1);
-        if (!q->dropped[q->drop_size]) return -1;
-        strcpy(q->dropped[q->drop_size], passenger_id);
-        q->drop_size++;
-        return -1;
-    }
-    // enqueue в основной буфер
-    char* copy = malloc(strlen(passenger_id) + 1);
-    if (!copy) return -1;
-    strcpy(copy, passenger_id);
-    q->data[q->tail] = copy;
-    q->times[q->tail] = service_time;
+static int array_queue_enqueue(queue_t* base, const char* passenger_id, size_t id_len, int service_time) {
+    array_queue_t* q = (array_queue_t*)base;
+    if (q->size == q->capacity) return -1;  // буфер полон — пассажир не принят
+    if (queue_rec_set(&q->recs[q->tail], passenger_id, id_len, service_time) < 0) return -1;
     q->tail = (q->tail + 1) % q->capacity;
     q->size++;
     return 0;
@@ -103,45 +62,38 @@ static int array_queue_enqueue(array_queue_t* q, const char* passenger_id, int s
  * Получение ID первого пассажира
  * Возвращает NULL, если очередь пуста
  */
-static const char* array_queue_front_id(const array_queue_t* q) {
-    return q->size ? q->data[q->head] : NULL;
+static const char* array_queue_front_id(const queue_t* base) {
+    const array_queue_t* q = (const array_queue_t*)base;
+    return q->size ? q->recs[q->head].id : NULL;
 }
 
 /**
  * Получение времени обслуживания первого пассажира
  * Возвращает -1, если очередь пуста
  */
-static int array_queue_front_service_time(const array_queue_t* q) {
-    return q->size ? q->times[q->head] : -1;
+static int array_queue_front_service_time(const queue_t* base) {
+    const array_queue_t* q = (const array_queue_t*)base;
+    return q->size ? q->recs[q->head].service_time : -1;
 }
 
 /**
  * Удаление первого пассажира из очереди
- * - освобождает строку ID
  * - сдвигает head и уменьшает размер
  * Возвращает 0 при успехе, -1 если очередь пуста
  */
-static int array_queue_dequeue(array_queue_t* q) {
+static int array_queue_dequeue(queue_t* base) {
+    array_queue_t* q = (array_queue_t*)base;
     if (!q->size) return -1;
-    free(q->data[q->head]);
     q->head = (q->head + 1) % q->capacity;
     q->size--;
     return 0;
 }
 
-/**
- * Проверка пустоты очереди
- * Возвращает 1 если size==0, иначе 0
- */
-static int array_queue_empty(const array_queue_t* q) {
-    return q->size == 0;
-}
-
 /**
  * Получение текущего числа элементов в очереди
  */
-static size_t array_queue_size(const array_queue_t* q) {
-    return q->size;
+static size_t array_queue_size(const queue_t* base) {
+    return ((const array_queue_t*)base)->size;
 }
 
 /**
@@ -149,41 +101,67 @@ static size_t array_queue_size(const array_queue_t* q) {
  * Используется для формирования снимков состояния
  * Возвращает число скопированных элементов
  */
-static size_t array_queue_dump_ids(const array_queue_t* q, char out[][MAX_ID_LEN]) {
+static size_t array_queue_dump_ids(const queue_t* base, char out[][MAX_ID_LEN]) {
+    const array_queue_t* q = (const array_queue_t*)base;
     size_t cnt = q->size;
     for (size_t i = 0; i < cnt; i++) {
-        size_t idx = (q->head + i) % q->capacity;
-        strncpy(out[i], q->data[idx], MAX_ID_LEN - 1);
-        out[i][MAX_ID_LEN - 1] = '\0';
+        queue_rec_copy_id(out[i], &q->recs[(q->head + i) % q->capacity]);
     }
     return cnt;
 }
 
 /**
- * Обработка ранее отказанных пассажиров (dropped):
- * проходит по всему dropped и пытается enqueue в основной буфер
- * - вставляет, если есть место, и освобождает dropped[i]
- * - иначе сохраняет для следующей попытки
+ * Пакетное добавление: пока есть место, пишет подряд без вызова enqueue
+ * на каждого. Возвращает число поставленных.
+ */
+static size_t array_queue_enqueue_bulk(queue_t* base, const queue_item_t* items, size_t n) {
+    array_queue_t* q = (array_queue_t*)base;
+    size_t room = q->capacity - q->size;
+    size_t k = 0;
+    for (; k < n && k < room; k++) {
+        if (queue_rec_set(&q->recs[q->tail], items[k].id, items[k].id_len, items[k].service_time) < 0) break;
+        if (++q->tail == q->capacity) q->tail = 0;
+    }
+    q->size += k;
+    return k;
+}
+
+/**
+ * Пакетное удаление первых n пассажиров
  */
-static void array_queue_process_dropped(array_queue_t* q) {
-    size_t write_idx = 0;
-    for (size_t read_idx = 0; read_idx < q->drop_size; ++read_idx) {
-        char* pid = q->dropped[read_idx];
-        if (q->size < q->capacity) {
-            // вставляем из dropped в очередь
-            char* copy = malloc(strlen(pid) + 1);
-            strcpy(copy, pid);
-            q->data[q->tail] = copy;
-            q->times[q->tail] = 0;  // время обслуживания хранить отдельно при необходимости
-            q->tail = (q->tail + 1) % q->capacity;
-            q->size++;
-            free(pid);
-        } else {
-            // оставляем в dropped для следующих попыток
-            q->dropped[write_idx++] = pid;
-        }
+static size_t array_queue_dequeue_bulk(queue_t* base, size_t n) {
+    array_queue_t* q = (array_queue_t*)base;
+    if (n > q->size) n = q->size;
+    q->head = (q->head + n) % q->capacity;
+    q->size -= n;
+    return n;
+}
+
+/**
+ * Обход очереди без копирования ID
+ */
+static size_t array_queue_foreach(const queue_t* base, queue_visit_fn visit, void* ctx) {
+    const array_queue_t* q = (const array_queue_t*)base;
+    size_t idx = q->head;
+    for (size_t i = 0; i < q->size; i++) {
+        const queue_rec_t* r = &q->recs[idx];
+        if (visit(r->id, r->id_len, r->service_time, ctx)) return i + 1;
+        if (++idx == q->capacity) idx = 0;
     }
-    q->drop_size = write_idx;
+    return q->size;
 }
 
-#endif // USE_ARRAY_QUEUE
+const queue_ops_t array_queue_ops = {
+    .name               = "array",
+    .create             = array_queue_create,
+    .destroy            = array_queue_destroy,
+    .enqueue            = array_queue_enqueue,
+    .front_id           = array_queue_front_id,
+    .front_service_time = array_queue_front_service_time,
+    .dequeue            = array_queue_dequeue,
+    .size               = array_queue_size,
+    .dump_ids           = array_queue_dump_ids,
+    .foreach            = array_queue_foreach,
+    .enqueue_bulk       = array_queue_enqueue_bulk,
+    .dequeue_bulk       = array_queue_dequeue_bulk,
+};
@@ -0,0 +1,216 @@
+/*
+ * Сквозной бенчмарк симуляции: генерирует входы с заданными параметрами,
+ * прогоняет весь конвейер run_simulation (разбор, сортировка, цикл событий,
+ * снимки, печать таблицы) на каждой реализации очереди и печатает
+ * по одной JSON-строке на прогон — их удобно складывать и сравнивать.
+ *
+ * Каждый прогон выполняется в отдельном процессе, чтобы пиковая память
+ * (peak_rss_kb) относилась только к нему.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "queue.h"
+#include "trace.h"
+#include "workload.h"
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static long peak_rss_kb(void) {
+#ifndef _WIN32
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) == 0) return ru.ru_maxrss;
+#endif
+    return -1;
+}
+
+/* Один прогон конвейера над готовым текстом входа; печатает JSON-строку */
+static int run_once(const workload_t* w, const char* text, size_t len,
+                    queue_backend_t backend, int repeat) {
+    trace_t tr;
+    sim_config_t cfg;
+    sim_config_init(&cfg);
+    cfg.backend = backend;
+    cfg.profile = 1;
+
+    double t0 = now_sec();
+    trace_init_buffer(&tr, text, len);
+    if (trace_parse(&tr) < 0) {
+        fprintf(stderr, "Error: failed to parse generated workload\n");
+        trace_free(&tr);
+        return -1;
+    }
+    double t1 = now_sec();
+    trace_sort(&tr);
+    double t2 = now_sec();
+
+    sim_table_t* table;
+    sim_stats_t st;
+    if (sim_run(&tr, &cfg, &table, &st) < 0) {
+        trace_free(&tr);
+        return -1;
+    }
+
+    FILE* sink = fopen("/dev/null", "w");
+    if (!sink) sink = tmpfile();
+    double t3 = now_sec();
+    if (sink) {
+        sim_table_print(table, sink);
+        fflush(sink);
+    }
+    double t4 = now_sec();
+    if (sink) fclose(sink);
+
+    size_t events = st.arrivals + st.departures;
+    char service[64], arrivals[64];
+    workload_format_service(w, service, sizeof(service));
+    workload_format_arrivals(w, arrivals, sizeof(arrivals));
+    printf("{\"desks\":%d,\"passengers\":%zu,\"rate\":%g,\"arrivals\":\"%s\",\"service\":\"%s\","
+           "\"id_len_min\":%d,\"id_len\":%d,"
+           "\"seed\":%llu,\"backend\":\"%s\",\"repeat\":%d,"
+           "\"parse_sec\":%.6f,\"sort_sec\":%.6f,\"loop_sec\":%.6f,\"snapshot_sec\":%.6f,"
+           "\"render_sec\":%.6f,\"events\":%zu,\"events_per_sec\":%.0f,\"columns\":%zu,"
+           "\"rejected\":%zu,\"peak_rss_kb\":%ld}\n",
+           w->desks, w->passengers, w->rate, arrivals, service,
+           w->id_len_min ? w->id_len_min : w->id_len, w->id_len,
+           (unsigned long long)w->seed, queue_backend_name(backend), repeat,
+           t1 - t0, t2 - t1, st.loop_sec, st.snapshot_sec,
+           t4 - t3, events, st.loop_sec > 0 ? (double)events / st.loop_sec : 0.0, st.columns,
+           st.rejected, peak_rss_kb());
+    fflush(stdout);
+
+    sim_table_free(table);
+    trace_free(&tr);
+    return 0;
+}
+
+/* Запускает run_once в дочернем процессе (если есть fork) */
+static int run_isolated(const workload_t* w, const char* text, size_t len,
+                        queue_backend_t backend, int repeat) {
+#ifndef _WIN32
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        _exit(run_once(w, text, len, backend, repeat) == 0 ? 0 : 1);
+    }
+    if (pid > 0) {
+        int status;
+        if (waitpid(pid, &status, 0) < 0) return -1;
+        return (WIFEXITED(status) && WEXITSTATUS(status) == 0) ? 0 : -1;
+    }
+#endif
+    return run_once(w, text, len, backend, repeat);
+}
+
+static int bench_workload(workload_t* w, const int* use_backend, int repeats) {
+    w->rate = workload_effective_rate(w);
+    size_t len;
+    char* text = workload_generate(w, &len);
+    if (!text) {
+        fprintf(stderr, "Error: malloc failed for workload\n");
+        return -1;
+    }
+    int rc = 0;
+    for (int b = 0; b < QUEUE_BACKEND_COUNT; b++) {
+        if (!use_backend[b]) continue;
+        for (int r = 0; r < repeats; r++) {
+            if (run_isolated(w, text, len, (queue_backend_t)b, r) < 0) rc = -1;
+        }
+    }
+    free(text);
+    return rc;
+}
+
+/* Разбирает список реализаций через запятую ("list,array") */
+static int parse_backends(const char* list, int* use_backend) {
+    memset(use_backend, 0, QUEUE_BACKEND_COUNT * sizeof(int));
+    char buf[128];
+    snprintf(buf, sizeof(buf), "%s", list);
+    for (char* tok = strtok(buf, ","); tok; tok = strtok(NULL, ",")) {
+        queue_backend_t b;
+        if (queue_backend_from_name(tok, &b) < 0) return -1;
+        use_backend[b] = 1;
+    }
+    return 0;
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  --desks=N          number of desks\n"
+            "  --passengers=N     number of passengers\n"
+            "  --rate=R           mean arrivals per time unit (default: 80%% load)\n"
+            "  --arrivals=SPEC    poisson | bursty:FACTOR:LEN (default poisson)\n"
+            "  --service=SPEC     const:A | uniform:A:B | exp:MEAN | pareto:ALPHA:XMIN |\n"
+            "                     lognormal:MU:SIGMA (default exp:5)\n"
+            "  --id-len=L|MIN:MAX passenger id length (default 8)\n"
+            "  --seed=S           generator seed (default 1)\n"
+            "  --backends=LIST    comma-separated queue backends (default: all)\n"
+            "  --repeat=K         runs per backend (default 1)\n"
+            "Without workload options a built-in matrix of workloads is run.\n"
+            "Output: one JSON object per run on stdout.\n",
+            prog);
+}
+
+int main(int argc, char** argv) {
+    workload_t w;
+    workload_init(&w);
+    int use_backend[QUEUE_BACKEND_COUNT];
+    for (int b = 0; b < QUEUE_BACKEND_COUNT; b++) use_backend[b] = 1;
+    int repeats = 1;
+    int custom = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        int ok = 1;
+        if      (strncmp(a, "--desks=", 8) == 0)      { w.desks = atoi(a + 8); custom = 1; ok = w.desks >= 2; }
+        else if (strncmp(a, "--passengers=", 13) == 0) { w.passengers = strtoull(a + 13, NULL, 10); custom = 1; }
+        else if (strncmp(a, "--rate=", 7) == 0)       { w.rate = atof(a + 7); custom = 1; }
+        else if (strncmp(a, "--service=", 10) == 0)   { ok = workload_parse_service(&w, a + 10) == 0; custom = 1; }
+        else if (strncmp(a, "--arrivals=", 11) == 0)  { ok = workload_parse_arrivals(&w, a + 11) == 0; custom = 1; }
+        else if (strncmp(a, "--id-len=", 9) == 0)     { ok = workload_parse_id_len(&w, a + 9) == 0; custom = 1; }
+        else if (strncmp(a, "--seed=", 7) == 0)       { w.seed = strtoull(a + 7, NULL, 10); }
+        else if (strncmp(a, "--backends=", 11) == 0)  { ok = parse_backends(a + 11, use_backend) == 0; }
+        else if (strncmp(a, "--repeat=", 9) == 0)     { repeats = atoi(a + 9); ok = repeats >= 1; }
+        else {
+            usage(argv[0]);
+            return strcmp(a, "--help") == 0 ? 0 : 1;
+        }
+        if (!ok) {
+            fprintf(stderr, "Error: invalid option '%s'\n", a);
+            return 1;
+        }
+    }
+
+    if (custom) {
+        return bench_workload(&w, use_backend, repeats) == 0 ? 0 : 1;
+    }
+
+    // Встроенная матрица: от пары стоек до тысяч, при загрузке 80%
+    static const struct { int desks; size_t passengers; } matrix[] = {
+        {    4,  20000 },
+        {   64, 100000 },
+        { 1024, 200000 },
+        { 4096, 200000 },
+    };
+    int rc = 0;
+    for (size_t k = 0; k < sizeof(matrix) / sizeof(matrix[0]); k++) {
+        workload_t m = w;
+        m.desks = matrix[k].desks;
+        m.passengers = matrix[k].passengers;
+        m.rate = 0.0;
+        if (bench_workload(&m, use_backend, repeats) < 0) rc = 1;
+    }
+    return rc;
+}
@@ -0,0 +1,207 @@
+#include <stdlib.h>
+#include <string.h>
+#include "queue_impl.h"
+
+#define CHUNK_RECS 64  // записей в одном блоке
+
+/**
+ * Очередь-дек на связанных блоках фиксированного размера (unrolled list).
+ * Внутри блока записи с id лежат подряд, поэтому enqueue, dequeue и обход
+ * идут по памяти последовательно, а переход по указателю нужен раз на
+ * CHUNK_RECS пассажиров. Блоки берутся из общего пула (queue_pool_t) и
+ * возвращаются в него, как только опустеют: память следует за реальной
+ * длиной очереди, а пустая стойка не держит ни одного блока.
+ */
+typedef struct chunk {
+    struct chunk* next;
+    queue_rec_t   recs[CHUNK_RECS];
+} chunk_t;
+
+const size_t chunk_size = sizeof(chunk_t);
+
+typedef struct {
+    queue_t       base;      // общий заголовок очереди (таблица функций)
+    chunk_t*      head;      // блок с первым пассажиром (NULL, если пусто)
+    chunk_t*      tail;      // блок с последним пассажиром
+    size_t        head_pos;  // индекс первого пассажира в head
+    size_t        tail_pos;  // индекс следующей свободной записи в tail
+    size_t        size;      // текущее число пассажиров
+    slab_t*       chunks;    // откуда берутся блоки
+    queue_pool_t* own_pool;  // свой пул, если общий не передан
+} chunk_queue_t;
+
+/* Создание пустой очереди; ёмкость не нужна — блоки берутся по мере роста */
+static queue_t* chunk_queue_create(size_t capacity, queue_pool_t* pool) {
+    (void)capacity;
+    chunk_queue_t* q = malloc(sizeof(chunk_queue_t));
+    if (!q) return NULL;
+    q->own_pool = NULL;
+    if (!pool) {
+        pool = q->own_pool = queue_pool_create();
+        if (!pool) {
+            free(q);
+            return NULL;
+        }
+    }
+    q->base.ops = &chunk_queue_ops;
+    q->head = q->tail = NULL;
+    q->head_pos = q->tail_pos = 0;
+    q->size = 0;
+    q->chunks = &pool->chunks;
+    return &q->base;
+}
+
+static void chunk_queue_destroy(queue_t* base) {
+    chunk_queue_t* q = (chunk_queue_t*)base;
+    if (q->own_pool) {
+        queue_pool_destroy(q->own_pool);
+    } else {
+        chunk_t* c = q->head;
+        while (c) {
+            chunk_t* next = c->next;
+            slab_free(q->chunks, c);
+            c = next;
+        }
+    }
+    free(q);
+}
+
+/* Место под следующую запись: новый блок, если tail заполнен. NULL при ошибке */
+static inline queue_rec_t* chunk_slot(chunk_queue_t* q) {
+    if (!q->tail || q->tail_pos == CHUNK_RECS) {
+        chunk_t* c = slab_alloc(q->chunks);
+        if (!c) return NULL;
+        c->next = NULL;
+        if (q->tail) q->tail->next = c;
+        else         q->head = c, q->head_pos = 0;
+        q->tail = c;
+        q->tail_pos = 0;
+    }
+    return &q->tail->recs[q->tail_pos];
+}
+
+static int chunk_queue_enqueue(queue_t* base, const char* passenger_id, size_t id_len, int service_time) {
+    chunk_queue_t* q = (chunk_queue_t*)base;
+    queue_rec_t* r = chunk_slot(q);
+    if (!r || queue_rec_set(r, passenger_id, id_len, service_time) < 0) return -1;
+    q->tail_pos++;
+    q->size++;
+    return 0;
+}
+
+static const char* chunk_queue_front_id(const queue_t* base) {
+    const chunk_queue_t* q = (const chunk_queue_t*)base;
+    return q->size ? q->head->recs[q->head_pos].id : NULL;
+}
+
+static int chunk_queue_front_service_time(const queue_t* base) {
+    const chunk_queue_t* q = (const chunk_queue_t*)base;
+    return q->size ? q->head->recs[q->head_pos].service_time : -1;
+}
+
+/* Снимает n (<= size) первых пассажиров, опустевшие блоки уходят в пул */
+static void chunk_drop_front(chunk_queue_t* q, size_t n) {
+    q->size -= n;
+    if (!q->size) {
+        // Очередь опустела: все её блоки больше не нужны
+        for (chunk_t* c = q->head; c;) {
+            chunk_t* next = c->next;
+            slab_free(q->chunks, c);
+            c = next;
+        }
+        q->head = q->tail = NULL;
+        q->head_pos = q->tail_pos = 0;
+        return;
+    }
+    n += q->head_pos;
+    while (n >= CHUNK_RECS) {
+        chunk_t* c = q->head;  // разобран целиком, а пассажиры есть и дальше
+        q->head = c->next;
+        slab_free(q->chunks, c);
+        n -= CHUNK_RECS;
+    }
+    q->head_pos = n;
+}
+
+static int chunk_queue_dequeue(queue_t* base) {
+    chunk_queue_t* q = (chunk_queue_t*)base;
+    if (!q->size) return -1;
+    chunk_drop_front(q, 1);
+    return 0;
+}
+
+static size_t chunk_queue_size(const queue_t* base) {
+    return ((const chunk_queue_t*)base)->size;
+}
+
+static size_t chunk_queue_dump_ids(const queue_t* base, char out[][MAX_ID_LEN]) {
+    const chunk_queue_t* q = (const chunk_queue_t*)base;
+    size_t cnt = 0;
+    size_t pos = q->head_pos;
+    for (const chunk_t* c = q->head; c; c = c->next, pos = 0) {
+        size_t end = (c == q->tail) ? q->tail_pos : CHUNK_RECS;
+        for (; pos < end; pos++) queue_rec_copy_id(out[cnt++], &c->recs[pos]);
+    }
+    return cnt;
+}
+
+static size_t chunk_queue_foreach(const queue_t* base, queue_visit_fn visit, void* ctx) {
+    const chunk_queue_t* q = (const chunk_queue_t*)base;
+    size_t cnt = 0;
+    size_t pos = q->head_pos;
+    for (const chunk_t* c = q->head; c; c = c->next, pos = 0) {
+        size_t end = (c == q->tail) ? q->tail_pos : CHUNK_RECS;
+        for (; pos < end; pos++) {
+            const queue_rec_t* r = &c->recs[pos];
+            cnt++;
+            if (visit(r->id, r->id_len, r->service_time, ctx)) return cnt;
+        }
+    }
+    return cnt;
+}
+
+/* Пакетное добавление: блок берётся один раз на CHUNK_RECS пассажиров */
+static size_t chunk_queue_enqueue_bulk(queue_t* base, const queue_item_t* items, size_t n) {
+    chunk_queue_t* q = (chunk_queue_t*)base;
+    size_t k = 0;
+    while (k < n) {
+        if (!chunk_slot(q)) break;
+        size_t end = k + (CHUNK_RECS - q->tail_pos);
+        if (end > n) end = n;
+        queue_rec_t* r = &q->tail->recs[q->tail_pos];
+        for (; k < end; k++, r++) {
+            if (queue_rec_set(r, items[k].id, items[k].id_len, items[k].service_time) < 0) {
+                // Уже записанные в этот блок учитываем и останавливаемся
+                q->size += (size_t)(r - &q->tail->recs[q->tail_pos]);
+                q->tail_pos = (size_t)(r - q->tail->recs);
+                return k;
+            }
+        }
+        size_t wrote = (size_t)(r - &q->tail->recs[q->tail_pos]);
+        q->tail_pos += wrote;
+        q->size += wrote;
+    }
+    return k;
+}
+
+static size_t chunk_queue_dequeue_bulk(queue_t* base, size_t n) {
+    chunk_queue_t* q = (chunk_queue_t*)base;
+    if (n > q->size) n = q->size;
+    if (n) chunk_drop_front(q, n);
+    return n;
+}
+
+const queue_ops_t chunk_queue_ops = {
+    .name               = "chunk",
+    .create             = chunk_queue_create,
+    .destroy            = chunk_queue_destroy,
+    .enqueue            = chunk_queue_enqueue,
+    .front_id           = chunk_queue_front_id,
+    .front_service_time = chunk_queue_front_service_time,
+    .dequeue            = chunk_queue_dequeue,
+    .size               = chunk_queue_size,
+    .dump_ids           = chunk_queue_dump_ids,
+    .foreach            = chunk_queue_foreach,
+    .enqueue_bulk       = chunk_queue_enqueue_bulk,
+    .dequeue_bulk       = chunk_queue_dequeue_bulk,
+};
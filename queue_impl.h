@@ -0,0 +1,121 @@
+#ifndef QUEUE_IMPL_H
+#define QUEUE_IMPL_H
+
+#include <stdlib.h>
+#include <string.h>
+#include "queue.h"
+
+/*
+ * Внутренний заголовок библиотеки: таблица функций реализации очереди.
+ * Каждая реализация (список, кольцевой буфер, ...) лежит в своём .c файле,
+ * заполняет одну константную таблицу queue_ops_t, а обёртки queue_* в queue.c
+ * просто вызывают функции из таблицы очереди. Так все реализации линкуются
+ * в одну библиотеку одновременно и выбираются при создании очереди.
+ */
+typedef struct queue_ops {
+    const char*  name;
+    queue_t*     (*create)(size_t capacity, queue_pool_t* pool);
+    void         (*destroy)(queue_t* q);
+    int          (*enqueue)(queue_t* q, const char* passenger_id, size_t id_len, int service_time);
+    const char*  (*front_id)(const queue_t* q);
+    int          (*front_service_time)(const queue_t* q);
+    int          (*dequeue)(queue_t* q);
+    size_t       (*size)(const queue_t* q);
+    size_t       (*dump_ids)(const queue_t* q, char out[][MAX_ID_LEN]);
+    size_t       (*foreach)(const queue_t* q, queue_visit_fn visit, void* ctx);
+    // Необязательные пакетные операции: NULL — queue.c выполняет их поэлементно
+    size_t       (*enqueue_bulk)(queue_t* q, const queue_item_t* items, size_t n);
+    size_t       (*dequeue_bulk)(queue_t* q, size_t n);
+} queue_ops_t;
+
+/*
+ * Общий заголовок всех очередей. Структура реализации начинается с него,
+ * поэтому указатель на неё можно приводить к queue_t* и обратно.
+ */
+struct queue {
+    const queue_ops_t* ops;
+};
+
+/*
+ * Запись пассажира, общая для всех реализаций (40 байт).
+ * id любой допустимой длины (до MAX_ID_LEN - 1) хранится прямо в записи,
+ * поэтому на enqueue/dequeue/front/dump нет ни выделения памяти, ни
+ * перехода по указателю, а освобождать при снятии ничего не нужно.
+ */
+typedef struct {
+    int           service_time;    // время обслуживания пассажира
+    unsigned char id_len;          // длина id
+    char          id[MAX_ID_LEN];  // id с '\0'
+} queue_rec_t;
+
+/* Заполняет запись. -1, если id длиннее MAX_ID_LEN - 1 */
+static inline int queue_rec_set(queue_rec_t* r, const char* id, size_t id_len, int service_time) {
+    if (id_len >= MAX_ID_LEN) return -1;
+    memcpy(r->id, id, id_len);
+    r->id[id_len] = '\0';
+    r->id_len = (unsigned char)id_len;
+    r->service_time = service_time;
+    return 0;
+}
+
+/* Копирует id с '\0' в out: поле целиком, постоянной длиной без ветвлений (хвост за '\0' не важен) */
+static inline void queue_rec_copy_id(char out[MAX_ID_LEN], const queue_rec_t* r) {
+    memcpy(out, r->id, MAX_ID_LEN);
+}
+
+/*
+ * Слэб: объекты одного размера нарезаются из блоков по block_objs штук.
+ * Освобождённые объекты хранятся в односвязном списке (указатель на
+ * следующий лежит в первых байтах самого объекта). Блоки нарезаются
+ * по мере надобности и возвращаются системе только в slab_release.
+ */
+typedef struct slab_block slab_block_t;
+
+typedef struct {
+    size_t        obj_size;    // размер объекта, кратен sizeof(void*)
+    size_t        block_objs;  // объектов в одном блоке
+    void*         free;        // список свободных объектов
+    char*         carve;       // следующий ненарезанный объект последнего блока
+    char*         carve_end;   // конец последнего блока
+    slab_block_t* blocks;      // все блоки (для освобождения)
+} slab_t;
+
+void  slab_init(slab_t* s, size_t obj_size, size_t block_objs);
+void  slab_release(slab_t* s);
+void* slab_grow(slab_t* s);   // медленный путь slab_alloc: новый блок
+
+static inline void* slab_alloc(slab_t* s) {
+    void* p = s->free;
+    if (p) {
+        s->free = *(void**)p;
+        return p;
+    }
+    if (s->carve < s->carve_end) {
+        p = s->carve;
+        s->carve += s->obj_size;
+        return p;
+    }
+    return slab_grow(s);
+}
+
+static inline void slab_free(slab_t* s, void* p) {
+    *(void**)p = s->free;
+    s->free = p;
+}
+
+/* Пул записей, общий для очередей (см. queue_pool_t в queue.h) */
+struct queue_pool {
+    slab_t nodes;   // узлы списка (queue_list.c)
+    slab_t chunks;  // блоки записей (queue_chunk.c)
+};
+
+/* Размеры узла списка и блока записей: нужны пулу до создания первой очереди */
+extern const size_t list_node_size;
+extern const size_t chunk_size;
+
+extern const queue_ops_t list_queue_ops;
+extern const queue_ops_t array_queue_ops;
+extern const queue_ops_t ring_queue_ops;
+extern const queue_ops_t chunk_queue_ops;
+
+#endif // QUEUE_IMPL_H
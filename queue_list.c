@@ -1,51 +1,82 @@
 #include <stdlib.h>
 #include <string.h>
-#include "queue.h"
-
-#ifndef USE_ARRAY_QUEUE
+#include "queue_impl.h"
 
 /**
  * Очередь на основе односвязного списка.
+ * Узлы берутся из слэба пула (queue_pool_t); запись пассажира вместе с id
+ * лежит прямо в узле (queue_rec_t), отдельного malloc под строку нет.
  */
 typedef struct node {
-    char*         id;            // строка-идентификатор пассажира
-    int           service_time;  // время обслуживания пассажира
-    struct node*  next;          // указатель на следующий узел
+    struct node*  next;  // указатель на следующий узел
+    queue_rec_t   rec;   // пассажир
 } node_t;
 
+const size_t list_node_size = sizeof(node_t);
+
 typedef struct {
-    node_t* head; // первый в очереди
-    node_t* tail; // последний в очереди
-    size_t  size; // текущее число пассажиров
+    queue_t       base;     // общий заголовок очереди (таблица функций)
+    node_t*       head;     // первый в очереди
+    node_t*       tail;     // последний в очереди
+    size_t        size;     // текущее число пассажиров
+    slab_t*       nodes;    // откуда берутся узлы
+    queue_pool_t* own_pool; // свой пул, если общий не передан
 } list_queue_t;
 
-/* Инициализация пустой очереди */
-static int list_queue_init(list_queue_t* q) {
+/* Создание пустой очереди; ёмкость списку не нужна */
+static queue_t* list_queue_create(size_t capacity, queue_pool_t* pool) {
+    (void)capacity;
+    list_queue_t* q = malloc(sizeof(list_queue_t));
+    if (!q) return NULL;
+    q->own_pool = NULL;
+    if (!pool) {
+        pool = q->own_pool = queue_pool_create();
+        if (!pool) {
+            free(q);
+            return NULL;
+        }
+    }
+    q->base.ops = &list_queue_ops;
     q->head = q->tail = NULL;
     q->size = 0;
-    return 0;
+    q->nodes = &pool->nodes;
+    return &q->base;
 }
 
-/* Освобождение памяти: удаление всех узлов и их ID */
-static void list_queue_destroy(list_queue_t* q) {
-    node_t* cur = q->head;
-    while (cur) {
-        node_t* tmp = cur->next;
-        free(cur->id);  // освобождаем строку ID
-        free(cur);      // освобождаем узел
-        cur = tmp;
+/* Освобождение памяти: узлы возвращаются в пул (свой пул — целиком) */
+static void list_queue_destroy(queue_t* base) {
+    list_queue_t* q = (list_queue_t*)base;
+    if (q->own_pool) {
+        queue_pool_destroy(q->own_pool);
+    } else {
+        node_t* cur = q->head;
+        while (cur) {
+            node_t* tmp = cur->next;
+            slab_free(q->nodes, cur);
+            cur = tmp;
+        }
     }
+    free(q);
+}
+
+/* Новый узел с копией ID или NULL (нет памяти или id длиннее MAX_ID_LEN - 1) */
+static inline node_t* list_node_new(list_queue_t* q, const char* passenger_id, size_t id_len,
+                                    int service_time) {
+    node_t* nd = slab_alloc(q->nodes);
+    if (!nd) return NULL;
+    if (queue_rec_set(&nd->rec, passenger_id, id_len, service_time) < 0) {
+        slab_free(q->nodes, nd);
+        return NULL;
+    }
+    nd->next = NULL;
+    return nd;
 }
 
 /* Добавление пассажира в конец списка */
-static int list_queue_enqueue(list_queue_t* q, const char* passenger_id, int service_time) {
-    node_t* nd = malloc(sizeof(node_t));
+static int list_queue_enqueue(queue_t* base, const char* passenger_id, size_t id_len, int service_time) {
+    list_queue_t* q = (list_queue_t*)base;
+    node_t* nd = list_node_new(q, passenger_id, id_len, service_time);
     if (!nd) return -1;
-    nd->id = malloc(strlen(passenger_id) + 1); // копируем ID
-    if (!nd->id) { free(nd); return -1; }
-    strcpy(nd->id, passenger_id);
-    nd->service_time = service_time;
-    nd->next = NULL;
     if (q->size == 0) {
         q->head = q->tail = nd; // первая запись
     } else {
@@ -57,46 +88,103 @@ static int list_queue_enqueue(list_queue_t* q, const char* passenger_id, int ser
 }
 
 /* Получение ID первого пассажира или NULL, если очередь пуста */
-static const char* list_queue_front_id(const list_queue_t* q) {
-    return q->size ? q->head->id : NULL;
+static const char* list_queue_front_id(const queue_t* base) {
+    const list_queue_t* q = (const list_queue_t*)base;
+    return q->size ? q->head->rec.id : NULL;
 }
 
 /* Получение времени обслуживания первого пассажира или -1 */
-static int list_queue_front_service_time(const list_queue_t* q) {
-    return q->size ? q->head->service_time : -1;
+static int list_queue_front_service_time(const queue_t* base) {
+    const list_queue_t* q = (const list_queue_t*)base;
+    return q->size ? q->head->rec.service_time : -1;
 }
 
 /* Удаление первого узла из списка */
-static int list_queue_dequeue(list_queue_t* q) {
+static int list_queue_dequeue(queue_t* base) {
+    list_queue_t* q = (list_queue_t*)base;
     if (!q->size) return -1; // пусто
     node_t* tmp = q->head;
     q->head = tmp->next;
     if (!q->head) q->tail = NULL; // очередь опустела
-    free(tmp->id); // освобождаем ID
-    free(tmp);     // освобождаем узел
+    slab_free(q->nodes, tmp);     // узел возвращается в пул
     q->size--;
     return 0;
 }
 
-/* Проверка на пустоту очереди */
-static int list_queue_empty(const list_queue_t* q) {
-    return q->size == 0;
+/* Пакетное добавление: цепочка узлов собирается отдельно и подвешивается за раз */
+static size_t list_queue_enqueue_bulk(queue_t* base, const queue_item_t* items, size_t n) {
+    list_queue_t* q = (list_queue_t*)base;
+    node_t* first = NULL;
+    node_t* last = NULL;
+    size_t k = 0;
+    for (; k < n; k++) {
+        node_t* nd = list_node_new(q, items[k].id, items[k].id_len, items[k].service_time);
+        if (!nd) break;
+        if (last) last->next = nd;
+        else      first = nd;
+        last = nd;
+    }
+    if (!k) return 0;
+    if (q->size == 0) q->head = first;
+    else              q->tail->next = first;
+    q->tail = last;
+    q->size += k;
+    return k;
+}
+
+/* Пакетное удаление первых n узлов */
+static size_t list_queue_dequeue_bulk(queue_t* base, size_t n) {
+    list_queue_t* q = (list_queue_t*)base;
+    if (n > q->size) n = q->size;
+    node_t* cur = q->head;
+    for (size_t k = 0; k < n; k++) {
+        node_t* tmp = cur->next;
+        slab_free(q->nodes, cur);
+        cur = tmp;
+    }
+    q->head = cur;
+    if (!cur) q->tail = NULL;
+    q->size -= n;
+    return n;
+}
+
+/* Обход без копирования ID */
+static size_t list_queue_foreach(const queue_t* base, queue_visit_fn visit, void* ctx) {
+    const list_queue_t* q = (const list_queue_t*)base;
+    size_t cnt = 0;
+    for (node_t* cur = q->head; cur; cur = cur->next) {
+        cnt++;
+        if (visit(cur->rec.id, cur->rec.id_len, cur->rec.service_time, ctx)) break;
+    }
+    return cnt;
 }
 
 /* Текущее число элементов в очереди */
-static size_t list_queue_size(const list_queue_t* q) {
-    return q->size;
+static size_t list_queue_size(const queue_t* base) {
+    return ((const list_queue_t*)base)->size;
 }
 
 /* Копирование всех ID в массив out; возвращает число элементов */
-static size_t list_queue_dump_ids(const list_queue_t* q, char out[][MAX_ID_LEN]) {
+static size_t list_queue_dump_ids(const queue_t* base, char out[][MAX_ID_LEN]) {
+    const list_queue_t* q = (const list_queue_t*)base;
     size_t cnt = 0;
     for (node_t* cur = q->head; cur; cur = cur->next) {
-        strncpy(out[cnt], cur->id, MAX_ID_LEN - 1);
-        out[cnt][MAX_ID_LEN - 1] = '\0';
-        cnt++;
+        queue_rec_copy_id(out[cnt++], &cur->rec);
     }
     return cnt;
 }
 
-#endif // USE_ARRAY_QUEUE
+const queue_ops_t list_queue_ops = {
+    .name               = "list",
+    .create             = list_queue_create,
+    .destroy            = list_queue_destroy,
+    .enqueue            = list_queue_enqueue,
+    .front_id           = list_queue_front_id,
+    .front_service_time = list_queue_front_service_time,
+    .dequeue            = list_queue_dequeue,
+    .size               = list_queue_size,
+    .dump_ids           = list_queue_dump_ids,
+    .foreach            = list_queue_foreach,
+    .enqueue_bulk       = list_queue_enqueue_bulk,
+    .dequeue_bulk       = list_queue_dequeue_bulk,
+};
@@ -0,0 +1,369 @@
+/*
+ * Микробенчмарк операций queue_t: для каждой реализации и глубины очереди
+ * от 1 до 1M меряет стоимость queue_enqueue, queue_dequeue, queue_front_id,
+ * queue_dump_ids, пакетных queue_enqueue_bulk/queue_dequeue_bulk
+ * (на одного пассажира) и обхода queue_foreach:
+ * - ns/op по CLOCK_MONOTONIC (за вычетом накладных расходов самого замера);
+ * - вызовы malloc/calloc/realloc и free на операцию (glibc: перехват malloc);
+ * - промахи кэша и ветвлений на операцию через perf_event_open (Linux),
+ *   если ядро разрешает счётчики; иначе в выводе null.
+ * Печатает по одной JSON-строке на пару (реализация, операция, глубина).
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "queue.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#define ID_LEN       8
+#define ROUND_OPS    256          // операций в одном замеренном раунде (не больше глубины)
+#define TARGET_OPS   (1u << 20)   // операций на одно измерение
+#define MAX_DEPTH    1000000
+
+
+// ----- Подсчёт выделений памяти ----- //
+
+static size_t alloc_calls;
+static size_t free_calls;
+
+#if defined(__GLIBC__)
+/* Перехватываем malloc в исполняемом файле: библиотека queue зовёт эти версии */
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t n, size_t size);
+extern void* __libc_realloc(void* p, size_t size);
+extern void  __libc_free(void* p);
+
+void* malloc(size_t size)           { alloc_calls++; return __libc_malloc(size); }
+void* calloc(size_t n, size_t size) { alloc_calls++; return __libc_calloc(n, size); }
+void* realloc(void* p, size_t size) { alloc_calls++; return __libc_realloc(p, size); }
+void  free(void* p)                 { if (p) free_calls++; __libc_free(p); }
+#define HAVE_ALLOC_COUNT 1
+#else
+#define HAVE_ALLOC_COUNT 0
+#endif
+
+
+// ----- Аппаратные счётчики ----- //
+
+static int fd_cache  = -1;
+static int fd_branch = -1;
+
+#ifdef __linux__
+static int perf_open(uint64_t config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+static void counters_open(void) {
+#ifdef __linux__
+    fd_cache  = perf_open(PERF_COUNT_HW_CACHE_MISSES);
+    fd_branch = perf_open(PERF_COUNT_HW_BRANCH_MISSES);
+#endif
+}
+
+static void counter_start(int fd) {
+#ifdef __linux__
+    if (fd < 0) return;
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#else
+    (void)fd;
+#endif
+}
+
+static void counter_stop(int fd) {
+#ifdef __linux__
+    if (fd < 0) return;
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+#else
+    (void)fd;
+#endif
+}
+
+static uint64_t counter_read_reset(int fd) {
+    uint64_t v = 0;
+#ifdef __linux__
+    if (fd < 0 || read(fd, &v, sizeof(v)) != (ssize_t)sizeof(v)) v = 0;
+    if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+#else
+    (void)fd;
+#endif
+    return v;
+}
+
+
+// ----- Замеры ----- //
+
+typedef struct {
+    double   ns;
+    uint64_t ops;
+    uint64_t allocs;
+    uint64_t frees;
+} sample_t;
+
+static double timer_overhead_ns;
+
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* Средняя стоимость пустого замера: вычитается из каждого раунда */
+static void calibrate_timer(void) {
+    uint64_t best = UINT64_MAX;
+    for (int rep = 0; rep < 5; rep++) {
+        uint64_t t0 = now_ns();
+        for (int i = 0; i < 1000; i++) {
+            volatile uint64_t a = now_ns();
+            volatile uint64_t b = now_ns();
+            (void)a; (void)b;
+        }
+        uint64_t dt = now_ns() - t0;
+        if (dt < best) best = dt;
+    }
+    timer_overhead_ns = (double)best / 2000.0;
+}
+
+static size_t   mark_allocs, mark_frees;
+static uint64_t mark_t;
+
+static inline void round_begin(void) {
+    mark_allocs = alloc_calls;
+    mark_frees  = free_calls;
+    counter_start(fd_cache);
+    counter_start(fd_branch);
+    mark_t = now_ns();
+}
+
+static inline void round_end(sample_t* s, size_t ops) {
+    uint64_t t = now_ns();
+    counter_stop(fd_cache);
+    counter_stop(fd_branch);
+    double ns = (double)(t - mark_t) - timer_overhead_ns;
+    s->ns     += ns > 0 ? ns : 0;
+    s->ops    += ops;
+    s->allocs += alloc_calls - mark_allocs;
+    s->frees  += free_calls - mark_frees;
+}
+
+static char (*ids)[ID_LEN + 1];
+
+static void make_ids(size_t n) {
+    ids = malloc(n * sizeof(*ids));
+    if (!ids) {
+        fprintf(stderr, "Error: malloc failed for ids\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < n; i++) {
+        snprintf(ids[i], sizeof(ids[i]), "p%07zu", i % 10000000);
+    }
+}
+
+static void fill(queue_t* q, size_t n, size_t* next) {
+    for (size_t i = 0; i < n; i++) {
+        size_t k = (*next)++ % (MAX_DEPTH + ROUND_OPS);
+        queue_enqueue_n(q, ids[k], ID_LEN, (int)(k & 0xff));
+    }
+}
+
+/* Та же последовательность пассажиров, что у fill, но одним вызовом */
+static void fill_bulk(queue_t* q, queue_item_t* items, size_t n, size_t* next) {
+    for (size_t i = 0; i < n; i++) {
+        size_t k = (*next)++ % (MAX_DEPTH + ROUND_OPS);
+        items[i].id = ids[k];
+        items[i].id_len = ID_LEN;
+        items[i].service_time = (int)(k & 0xff);
+    }
+    queue_enqueue_bulk(q, items, n);
+}
+
+/* queue_visit_fn для замера обхода: суммирует времена обслуживания */
+static int visit_sum(const char* id, size_t id_len, int service_time, void* ctx) {
+    *(size_t*)ctx += (size_t)service_time + (unsigned char)id[id_len - 1];
+    return 0;
+}
+
+static void report(const char* backend, const char* op, size_t depth, const sample_t* s,
+                   uint64_t cache, uint64_t branch) {
+    double ops = s->ops ? (double)s->ops : 1.0;
+    printf("{\"backend\":\"%s\",\"op\":\"%s\",\"depth\":%zu,\"ops\":%llu,\"ns_per_op\":%.2f",
+           backend, op, depth, (unsigned long long)s->ops, s->ns / ops);
+    if (HAVE_ALLOC_COUNT) {
+        printf(",\"allocs_per_op\":%.3f,\"frees_per_op\":%.3f", s->allocs / ops, s->frees / ops);
+    } else {
+        printf(",\"allocs_per_op\":null,\"frees_per_op\":null");
+    }
+    if (fd_cache >= 0)  printf(",\"cache_misses_per_op\":%.4f", cache / ops);
+    else                printf(",\"cache_misses_per_op\":null");
+    if (fd_branch >= 0) printf(",\"branch_misses_per_op\":%.4f", branch / ops);
+    else                printf(",\"branch_misses_per_op\":null");
+    printf("}\n");
+    fflush(stdout);
+}
+
+/* Одна глубина: все операции для реализации backend */
+static int bench_depth(queue_backend_t backend, size_t depth) {
+    const char* name = queue_backend_name(backend);
+    size_t batch = depth < ROUND_OPS ? depth : ROUND_OPS;
+    size_t rounds = TARGET_OPS / batch;
+    size_t next = 0;
+
+    queue_t* q = queue_create_with(backend, depth + ROUND_OPS);
+    if (!q) {
+        fprintf(stderr, "Error: failed to create %s queue of depth %zu\n", name, depth);
+        return -1;
+    }
+    fill(q, depth, &next);
+
+    // enqueue: раунд поднимает глубину с depth до depth + batch, затем возвращаем её
+    sample_t s = {0};
+    counter_read_reset(fd_cache);
+    counter_read_reset(fd_branch);
+    for (size_t r = 0; r < rounds; r++) {
+        round_begin();
+        fill(q, batch, &next);
+        round_end(&s, batch);
+        for (size_t i = 0; i < batch; i++) queue_dequeue(q);
+    }
+    report(name, "enqueue", depth, &s, counter_read_reset(fd_cache), counter_read_reset(fd_branch));
+
+    // dequeue: раунд опускает глубину с depth до depth - batch, затем доливаем
+    memset(&s, 0, sizeof(s));
+    for (size_t r = 0; r < rounds; r++) {
+        round_begin();
+        for (size_t i = 0; i < batch; i++) queue_dequeue(q);
+        round_end(&s, batch);
+        fill(q, batch, &next);
+    }
+    report(name, "dequeue", depth, &s, counter_read_reset(fd_cache), counter_read_reset(fd_branch));
+
+    // front_id: не меняет очередь, раунд — ROUND_OPS вызовов
+    memset(&s, 0, sizeof(s));
+    size_t sink = 0;
+    for (size_t r = 0; r < TARGET_OPS / ROUND_OPS; r++) {
+        round_begin();
+        for (size_t i = 0; i < ROUND_OPS; i++) {
+            const char* id = queue_front_id(q);
+            sink += (size_t)id[i & 7];
+        }
+        round_end(&s, ROUND_OPS);
+    }
+    report(name, "front_id", depth, &s, counter_read_reset(fd_cache), counter_read_reset(fd_branch));
+
+    // dump_ids: копирует всю очередь; ops — число вызовов, цена растёт с глубиной
+    char (*out)[MAX_ID_LEN] = malloc(depth * sizeof(*out));
+    if (!out) {
+        fprintf(stderr, "Error: malloc failed for dump buffer\n");
+        queue_destroy(q);
+        return -1;
+    }
+    memset(&s, 0, sizeof(s));
+    size_t calls = TARGET_OPS / depth;
+    if (calls < 4) calls = 4;
+    counter_read_reset(fd_cache);
+    counter_read_reset(fd_branch);
+    for (size_t r = 0; r < calls; r++) {
+        round_begin();
+        sink += queue_dump_ids(q, out);
+        round_end(&s, 1);
+    }
+    report(name, "dump_ids", depth, &s, counter_read_reset(fd_cache), counter_read_reset(fd_branch));
+    free(out);
+
+    // foreach: обход без копирования; ops — число вызовов, как у dump_ids
+    memset(&s, 0, sizeof(s));
+    for (size_t r = 0; r < calls; r++) {
+        round_begin();
+        queue_foreach(q, visit_sum, &sink);
+        round_end(&s, 1);
+    }
+    report(name, "foreach", depth, &s, counter_read_reset(fd_cache), counter_read_reset(fd_branch));
+
+    // enqueue_bulk / dequeue_bulk: раунд — один вызов на batch пассажиров
+    queue_item_t items[ROUND_OPS];
+    memset(&s, 0, sizeof(s));
+    for (size_t r = 0; r < rounds; r++) {
+        round_begin();
+        fill_bulk(q, items, batch, &next);
+        round_end(&s, batch);
+        queue_dequeue_bulk(q, batch);
+    }
+    report(name, "enqueue_bulk", depth, &s, counter_read_reset(fd_cache), counter_read_reset(fd_branch));
+
+    memset(&s, 0, sizeof(s));
+    for (size_t r = 0; r < rounds; r++) {
+        round_begin();
+        queue_dequeue_bulk(q, batch);
+        round_end(&s, batch);
+        fill_bulk(q, items, batch, &next);
+    }
+    report(name, "dequeue_bulk", depth, &s, counter_read_reset(fd_cache), counter_read_reset(fd_branch));
+
+    queue_destroy(q);
+    return sink == (size_t)-1 ? -1 : 0;  // sink не даёт компилятору выкинуть циклы
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "Usage: %s [--backend=NAME] [--max-depth=N]\n"
+            "  --backend=NAME   measure only this queue backend (default: all)\n"
+            "  --max-depth=N    largest queue depth, depths go 1, 10, 100, ... (default %d)\n",
+            prog, MAX_DEPTH);
+}
+
+int main(int argc, char** argv) {
+    int only = -1;
+    size_t max_depth = MAX_DEPTH;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--backend=", 10) == 0) {
+            queue_backend_t b;
+            if (queue_backend_from_name(argv[i] + 10, &b) < 0) {
+                fprintf(stderr, "Error: unknown queue backend '%s'\n", argv[i] + 10);
+                return 1;
+            }
+            only = (int)b;
+        } else if (strncmp(argv[i], "--max-depth=", 12) == 0) {
+            max_depth = strtoull(argv[i] + 12, NULL, 10);
+            if (max_depth < 1 || max_depth > MAX_DEPTH) {
+                fprintf(stderr, "Error: --max-depth must be in 1..%d\n", MAX_DEPTH);
+                return 1;
+            }
+        } else {
+            usage(argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    calibrate_timer();
+    counters_open();
+    if (fd_cache < 0 || fd_branch < 0) {
+        fprintf(stderr, "Note: hardware counters unavailable, reporting null\n");
+    }
+    make_ids(MAX_DEPTH + ROUND_OPS);
+
+    int rc = 0;
+    for (int b = 0; b < QUEUE_BACKEND_COUNT; b++) {
+        if (only >= 0 && b != only) continue;
+        for (size_t depth = 1; depth <= max_depth; depth *= 10) {
+            if (bench_depth((queue_backend_t)b, depth) < 0) rc = 1;
+        }
+    }
+    free(ids);
+    return rc;
+}
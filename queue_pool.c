@@ -0,0 +1,60 @@
+#include <stdlib.h>
+#include "queue_impl.h"
+
+// ----- Слэб и пул записей очередей ----- //
+
+/* Заголовок блока; объекты идут сразу за ним */
+struct slab_block {
+    slab_block_t* next;
+    void*         align_;  // держит начало объектов выровненным на 16
+};
+
+#define NODES_PER_BLOCK  1024  // узлы списка невелики (~50 байт)
+#define CHUNKS_PER_BLOCK 16    // блок записей — несколько КБ
+
+void slab_init(slab_t* s, size_t obj_size, size_t block_objs) {
+    if (obj_size < sizeof(void*)) obj_size = sizeof(void*);
+    s->obj_size  = (obj_size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+    s->block_objs = block_objs;
+    s->free      = NULL;
+    s->carve     = NULL;
+    s->carve_end = NULL;
+    s->blocks    = NULL;
+}
+
+void* slab_grow(slab_t* s) {
+    slab_block_t* b = malloc(sizeof(slab_block_t) + s->block_objs * s->obj_size);
+    if (!b) return NULL;
+    b->next = s->blocks;
+    s->blocks = b;
+    // Нарезаем лениво: страницы блока трогаются, только когда объекты понадобятся
+    char* objs = (char*)(b + 1);
+    s->carve = objs + s->obj_size;
+    s->carve_end = objs + s->block_objs * s->obj_size;
+    return objs;
+}
+
+void slab_release(slab_t* s) {
+    slab_block_t* b = s->blocks;
+    while (b) {
+        slab_block_t* next = b->next;
+        free(b);
+        b = next;
+    }
+    slab_init(s, s->obj_size, s->block_objs);
+}
+
+queue_pool_t* queue_pool_create(void) {
+    queue_pool_t* pool = malloc(sizeof(queue_pool_t));
+    if (!pool) return NULL;
+    slab_init(&pool->nodes, list_node_size, NODES_PER_BLOCK);
+    slab_init(&pool->chunks, chunk_size, CHUNKS_PER_BLOCK);
+    return pool;
+}
+
+void queue_pool_destroy(queue_pool_t* pool) {
+    if (!pool) return;
+    slab_release(&pool->nodes);
+    slab_release(&pool->chunks);
+    free(pool);
+}
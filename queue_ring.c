@@ -0,0 +1,167 @@
+#include <stdlib.h>
+#include <string.h>
+#include "queue_impl.h"
+
+#define RING_MIN_CAPACITY 16  // записей в только что созданном кольце
+
+/**
+ * Очередь на растущем кольцевом буфере.
+ * Ёмкость — степень двойки, индекс записи берётся по маске, а не через %.
+ * Записи фиксированного размера (queue_rec_t, id целиком внутри) лежат
+ * подряд, поэтому enqueue не выделяет память под строку и не отказывает:
+ * когда места нет, буфер удваивается.
+ */
+typedef struct {
+    queue_t      base;  // общий заголовок очереди (таблица функций)
+    queue_rec_t* recs;  // буфер на mask + 1 записей
+    size_t       mask;  // ёмкость - 1
+    size_t       head;  // индекс первой записи
+    size_t       size;  // текущее число пассажиров
+} ring_queue_t;
+
+/*
+ * Создание пустого кольца. Ёмкость стоек сильно различается, поэтому
+ * capacity не резервируется: кольцо начинает с RING_MIN_CAPACITY и растёт.
+ */
+static queue_t* ring_queue_create(size_t capacity, queue_pool_t* pool) {
+    (void)capacity;
+    (void)pool;  // записи лежат в самом буфере
+    size_t cap = RING_MIN_CAPACITY;
+    ring_queue_t* q = malloc(sizeof(ring_queue_t));
+    if (!q) return NULL;
+    q->recs = malloc(cap * sizeof(queue_rec_t));
+    if (!q->recs) {
+        free(q);
+        return NULL;
+    }
+    q->base.ops = &ring_queue_ops;
+    q->mask = cap - 1;
+    q->head = q->size = 0;
+    return &q->base;
+}
+
+static void ring_queue_destroy(queue_t* base) {
+    ring_queue_t* q = (ring_queue_t*)base;
+    free(q->recs);
+    free(q);
+}
+
+/*
+ * Удвоение ёмкости. После realloc записи [head, cap) стоят на месте,
+ * а перенесённая через край часть [0, tail) переезжает в [cap, cap + tail),
+ * чтобы очередь снова шла подряд от head. Если заворот длиннее хвоста
+ * до конца старого буфера, дешевле перенести хвост [head, cap) в конец
+ * нового буфера — переносится меньший из двух кусков.
+ */
+static int ring_grow(ring_queue_t* q) {
+    size_t cap = q->mask + 1;
+    queue_rec_t* recs = realloc(q->recs, 2 * cap * sizeof(queue_rec_t));
+    if (!recs) return -1;
+    size_t upper = cap - q->head;  // записей от head до конца старого буфера
+    if (q->size > upper) {
+        size_t wrapped = q->size - upper;
+        if (wrapped <= upper) {
+            memcpy(recs + cap, recs, wrapped * sizeof(queue_rec_t));
+        } else {
+            memcpy(recs + 2 * cap - upper, recs + q->head, upper * sizeof(queue_rec_t));
+            q->head = 2 * cap - upper;
+        }
+    }
+    q->recs = recs;
+    q->mask = 2 * cap - 1;
+    return 0;
+}
+
+/* Добавление пассажира; -1 только при ошибке realloc или длинном id */
+static int ring_queue_enqueue(queue_t* base, const char* passenger_id, size_t id_len, int service_time) {
+    ring_queue_t* q = (ring_queue_t*)base;
+    if (q->size > q->mask && ring_grow(q) < 0) return -1;
+    if (queue_rec_set(&q->recs[(q->head + q->size) & q->mask], passenger_id, id_len, service_time) < 0) {
+        return -1;
+    }
+    q->size++;
+    return 0;
+}
+
+static const char* ring_queue_front_id(const queue_t* base) {
+    const ring_queue_t* q = (const ring_queue_t*)base;
+    return q->size ? q->recs[q->head].id : NULL;
+}
+
+static int ring_queue_front_service_time(const queue_t* base) {
+    const ring_queue_t* q = (const ring_queue_t*)base;
+    return q->size ? q->recs[q->head].service_time : -1;
+}
+
+static int ring_queue_dequeue(queue_t* base) {
+    ring_queue_t* q = (ring_queue_t*)base;
+    if (!q->size) return -1;
+    q->head = (q->head + 1) & q->mask;
+    q->size--;
+    return 0;
+}
+
+static size_t ring_queue_size(const queue_t* base) {
+    return ((const ring_queue_t*)base)->size;
+}
+
+static size_t ring_queue_dump_ids(const queue_t* base, char out[][MAX_ID_LEN]) {
+    const ring_queue_t* q = (const ring_queue_t*)base;
+    const queue_rec_t* recs = q->recs;
+    size_t head = q->head, mask = q->mask, n = q->size;
+    for (size_t i = 0; i < n; i++) {
+        queue_rec_copy_id(out[i], &recs[(head + i) & mask]);
+    }
+    return n;
+}
+
+static size_t ring_queue_foreach(const queue_t* base, queue_visit_fn visit, void* ctx) {
+    const ring_queue_t* q = (const ring_queue_t*)base;
+    const queue_rec_t* recs = q->recs;
+    size_t head = q->head, mask = q->mask, n = q->size;
+    for (size_t i = 0; i < n; i++) {
+        const queue_rec_t* r = &recs[(head + i) & mask];
+        if (visit(r->id, r->id_len, r->service_time, ctx)) return i + 1;
+    }
+    return n;
+}
+
+/* Пакетное добавление: место под всю пачку готовится заранее */
+static size_t ring_queue_enqueue_bulk(queue_t* base, const queue_item_t* items, size_t n) {
+    ring_queue_t* q = (ring_queue_t*)base;
+    size_t k = 0;
+    while (k < n) {
+        if (q->size > q->mask && ring_grow(q) < 0) break;
+        size_t room = q->mask + 1 - q->size;
+        size_t end = n - k < room ? n : k + room;
+        for (; k < end; k++) {
+            queue_rec_t* r = &q->recs[(q->head + q->size) & q->mask];
+            if (queue_rec_set(r, items[k].id, items[k].id_len, items[k].service_time) < 0) return k;
+            q->size++;
+        }
+    }
+    return k;
+}
+
+static size_t ring_queue_dequeue_bulk(queue_t* base, size_t n) {
+    ring_queue_t* q = (ring_queue_t*)base;
+    if (n > q->size) n = q->size;
+    q->head = (q->head + n) & q->mask;
+    q->size -= n;
+    return n;
+}
+
+const queue_ops_t ring_queue_ops = {
+    .name               = "ring",
+    .create             = ring_queue_create,
+    .destroy            = ring_queue_destroy,
+    .enqueue            = ring_queue_enqueue,
+    .front_id           = ring_queue_front_id,
+    .front_service_time = ring_queue_front_service_time,
+    .dequeue            = ring_queue_dequeue,
+    .size               = ring_queue_size,
+    .dump_ids           = ring_queue_dump_ids,
+    .foreach            = ring_queue_foreach,
+    .enqueue_bulk       = ring_queue_enqueue_bulk,
+    .dequeue_bulk       = ring_queue_dequeue_bulk,
+};
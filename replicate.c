@@ -0,0 +1,242 @@
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "queue.h"
+#include "rng.h"
+#include "trace.h"
+
+#define REPLICATE_METRICS 4
+#define REPLICATE_MAX_THREADS 256
+
+
+
+// ----- Накопление статистики ----- //
+
+/* Накопитель Уэлфорда: среднее и дисперсия без хранения всех значений */
+typedef struct {
+    size_t n;
+    double mean;
+    double m2;
+    double min;
+    double max;
+} running_stat_t;
+
+static void running_stat_add(running_stat_t* s, double x) {
+    s->n++;
+    if (s->n == 1) {
+        s->min = s->max = x;
+    } else {
+        if (x < s->min) s->min = x;
+        if (x > s->max) s->max = x;
+    }
+    double delta = x - s->mean;
+    s->mean += delta / (double)s->n;
+    s->m2 += delta * (x - s->mean);
+}
+
+/* Квантиль t-распределения Стьюдента уровня 0.975 для df степеней свободы */
+static double t_quantile_975(size_t df) {
+    static const double table[] = {
+        0.0,   12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179,  2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074,  2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    if (df < sizeof(table) / sizeof(table[0])) return table[df];
+    return 1.96;
+}
+
+static double running_stat_half_width(const running_stat_t* s) {
+    if (s->n < 2) return INFINITY;
+    double var = s->m2 / (double)(s->n - 1);
+    return t_quantile_975(s->n - 1) * sqrt(var / (double)s->n);
+}
+
+static void running_stat_summary(const running_stat_t* s, sim_metric_summary_t* out) {
+    out->mean = s->mean;
+    out->half_width = s->n >= 2 ? running_stat_half_width(s) : 0.0;
+    out->min = s->min;
+    out->max = s->max;
+}
+
+
+
+// ----- Пул потоков ----- //
+
+/*
+ * Общее состояние серии. Потоки берут следующий номер прогона под mutex,
+ * прогоняют его без блокировок (трасса только читается) и кладут метрики
+ * в results[k]. Накопители пополняются строго по порядку номеров:
+ * prefix — сколько первых прогонов уже учтено. Поэтому и итог, и момент
+ * остановки не зависят от числа потоков и порядка их завершения.
+ */
+typedef struct {
+    const trace_t*                tr;
+    const sim_config_t*           cfg;
+    const sim_replicate_config_t* rc;
+
+    pthread_mutex_t lock;
+    size_t          next;     // следующий номер прогона для раздачи
+    size_t          prefix;   // учтено первых прогонов
+    int             stop;
+    int             failed;
+    int             converged;
+    double        (*results)[REPLICATE_METRICS];
+    unsigned char*  done;
+    running_stat_t  stats[REPLICATE_METRICS];
+} replicate_state_t;
+
+/* Зерно прогона k: базовое зерно, перемешанное с номером прогона */
+static uint64_t replication_seed(uint64_t base, size_t k) {
+    uint64_t x = base ^ ((uint64_t)k * 0xD1B54A32D192ED03ULL);
+    return splitmix64(&x);
+}
+
+/* Учитывает готовые прогоны по порядку и решает, можно ли остановиться. Под lock. */
+static void replicate_advance(replicate_state_t* rs) {
+    const sim_replicate_config_t* rc = rs->rc;
+    while (rs->prefix < rs->next && rs->done[rs->prefix]) {
+        for (int m = 0; m < REPLICATE_METRICS; m++) {
+            running_stat_add(&rs->stats[m], rs->results[rs->prefix][m]);
+        }
+        rs->prefix++;
+        if (rs->prefix >= rc->min_reps && rc->rel_ci > 0) {
+            const running_stat_t* w = &rs->stats[0];
+            if (running_stat_half_width(w) <= rc->rel_ci * fabs(w->mean)) {
+                rs->converged = 1;
+                rs->stop = 1;
+                return;
+            }
+        }
+        if (rs->prefix >= rc->max_reps) {
+            rs->stop = 1;
+            return;
+        }
+    }
+}
+
+static void* replicate_worker(void* arg) {
+    replicate_state_t* rs = arg;
+    sim_config_t cfg = *rs->cfg;
+    cfg.profile = 0;
+    cfg.metrics = NULL;  // метрики одного прогона тут не нужны, а общий объект гонялся бы
+
+    pthread_mutex_lock(&rs->lock);
+    while (!rs->stop && rs->next < rs->rc->max_reps) {
+        size_t k = rs->next++;
+        pthread_mutex_unlock(&rs->lock);
+
+        cfg.seed = replication_seed(rs->rc->seed, k);
+        sim_stats_t st;
+        int rc = sim_run(rs->tr, &cfg, NULL, &st);
+
+        pthread_mutex_lock(&rs->lock);
+        if (rc < 0) {
+            rs->failed = 1;
+            rs->stop = 1;
+            break;
+        }
+        rs->results[k][0] = st.mean_wait;
+        rs->results[k][1] = (double)st.max_wait;
+        rs->results[k][2] = (double)st.max_queue;
+        rs->results[k][3] = (double)st.makespan;
+        rs->done[k] = 1;
+        if (!rs->stop) replicate_advance(rs);
+    }
+    pthread_mutex_unlock(&rs->lock);
+    return NULL;
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+void sim_replicate_config_init(sim_replicate_config_t* rc) {
+    rc->min_reps = 10;
+    rc->max_reps = 1000;
+    rc->rel_ci   = 0.01;
+    rc->threads  = 0;
+    rc->seed     = 1;
+}
+
+int sim_replicate(const trace_t* tr, const sim_config_t* cfg,
+                  const sim_replicate_config_t* rc, sim_replicate_result_t* res) {
+    if (rc->max_reps == 0) {
+        fprintf(stderr, "Error: at least one replication is required\n");
+        return -1;
+    }
+    int threads = rc->threads;
+    if (threads <= 0) {
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = ncpu > 0 ? (int)ncpu : 1;
+    }
+    if (threads > REPLICATE_MAX_THREADS) threads = REPLICATE_MAX_THREADS;
+    if ((size_t)threads > rc->max_reps) threads = (int)rc->max_reps;
+
+    replicate_state_t rs;
+    memset(&rs, 0, sizeof(rs));
+    rs.tr = tr;
+    rs.cfg = cfg;
+    rs.rc = rc;
+    rs.results = malloc(rc->max_reps * sizeof(*rs.results));
+    rs.done = calloc(rc->max_reps, 1);
+    pthread_t* tids = malloc((size_t)threads * sizeof(pthread_t));
+    if (!rs.results || !rs.done || !tids) {
+        fprintf(stderr, "Error: malloc failed for %zu replications\n", rc->max_reps);
+        free(rs.results);
+        free(rs.done);
+        free(tids);
+        return -1;
+    }
+    pthread_mutex_init(&rs.lock, NULL);
+
+    double t0 = now_sec();
+    int started = 0;
+    for (; started < threads; started++) {
+        if (pthread_create(&tids[started], NULL, replicate_worker, &rs) != 0) break;
+    }
+    if (started == 0) {
+        // Потоки недоступны — выполняем серию в текущем
+        replicate_worker(&rs);
+    }
+    for (int i = 0; i < started; i++) pthread_join(tids[i], NULL);
+    double wall = now_sec() - t0;
+
+    pthread_mutex_destroy(&rs.lock);
+    free(rs.results);
+    free(rs.done);
+    free(tids);
+    if (rs.failed) return -1;
+
+    memset(res, 0, sizeof(*res));
+    res->reps = rs.prefix;
+    res->threads = started ? started : 1;
+    res->converged = rs.converged;
+    res->wall_sec = wall;
+    running_stat_summary(&rs.stats[0], &res->mean_wait);
+    running_stat_summary(&rs.stats[1], &res->max_wait);
+    running_stat_summary(&rs.stats[2], &res->max_queue);
+    running_stat_summary(&rs.stats[3], &res->makespan);
+    return 0;
+}
+
+void sim_replicate_print(const sim_replicate_result_t* res, FILE* out) {
+    fprintf(out, "replications: %zu (%s), threads: %d, %.3f s\n",
+            res->reps, res->converged ? "converged" : "limit reached", res->threads, res->wall_sec);
+    fprintf(out, "%-10s %14s %14s %14s %14s\n", "metric", "mean", "ci95", "min", "max");
+    const struct { const char* name; const sim_metric_summary_t* s; } rows[] = {
+        { "mean_wait", &res->mean_wait },
+        { "max_wait",  &res->max_wait  },
+        { "max_queue", &res->max_queue },
+        { "makespan",  &res->makespan  },
+    };
+    for (size_t i = 0; i < sizeof(rows) / sizeof(rows[0]); i++) {
+        fprintf(out, "%-10s %14.4f %14.4f %14.4f %14.4f\n", rows[i].name,
+                rows[i].s->mean, rows[i].s->half_width, rows[i].s->min, rows[i].s->max);
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+/*
+ * Генератор псевдослучайных чисел xoshiro256** со своим состоянием:
+ * у каждой симуляции (и каждого потока) свой rng_t, общих блокировок нет,
+ * а одно и то же зерно всегда даёт одну и ту же последовательность.
+ */
+typedef struct {
+    uint64_t s[4];
+} rng_t;
+
+/* Шаг splitmix64: перемешивает *x и возвращает следующее 64-битное значение */
+static inline uint64_t splitmix64(uint64_t* x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/* Инициализирует состояние из зерна (любое, включая 0) */
+static inline void rng_seed(rng_t* r, uint64_t seed) {
+    for (int i = 0; i < 4; i++) r->s[i] = splitmix64(&seed);
+}
+
+static inline uint64_t rng_rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t rng_next(rng_t* r) {
+    uint64_t* s = r->s;
+    uint64_t result = rng_rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rng_rotl(s[3], 45);
+    return result;
+}
+
+/*
+ * Равномерное целое на [0, range) без смещения по модулю (метод Лемира:
+ * умножение вместо деления, деление только в редком случае отбраковки).
+ * range должен быть больше 0.
+ */
+static inline uint32_t rng_bounded(rng_t* r, uint32_t range) {
+    uint64_t m = (rng_next(r) >> 32) * (uint64_t)range;
+    uint32_t low = (uint32_t)m;
+    if (low < range) {
+        uint32_t threshold = (uint32_t)(-range) % range;
+        while (low < threshold) {
+            m = (rng_next(r) >> 32) * (uint64_t)range;
+            low = (uint32_t)m;
+        }
+    }
+    return (uint32_t)(m >> 32);
+}
+
+/* Равномерное число на [0, 1) */
+static inline double rng_unit(rng_t* r) {
+    return (double)(rng_next(r) >> 11) * 0x1p-53;
+}
+
+#endif // RNG_H
@@ -0,0 +1,1595 @@
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "queue.h"
+#include "rng.h"
+#include "trace.h"
+
+#define DESK_CAPACITY 1000  // ёмкость стойки array, если queue_limit не задан
+#define INF_TIME 1000000000
+#define LOG_COMPACT_MIN 4096  // без таблицы журнал стойки сжимается, когда голова ушла дальше этого
+#define SIM_MAX_CHOICES 64    // наибольшее d для power-of-d
+#define OUT_BUF_SIZE (1 << 20)  // буфер вывода таблицы
+#define TRIM_MIN 4096           // sim_add_arrival: записи сжимаются не раньше стольких приходов
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+
+// ----- Структуры и функции для симуляции ----- //
+
+/*
+ * Гарантирует место под need элементов размера elem в массиве *arr ёмкости *cap.
+ * Ёмкость растёт удвоением, поэтому добавление в конец амортизированно O(1).
+ * Возвращает 0 при успехе, -1 при ошибке realloc (старый массив остаётся целым).
+ */
+static int reserve(void** arr, size_t* cap, size_t need, size_t elem) {
+    if (need <= *cap) return 0;
+    size_t newcap = *cap ? *cap : 16;
+    while (newcap < need) newcap *= 2;
+    void* tmp = realloc(*arr, newcap * elem);
+    if (!tmp) return -1;
+    *arr = tmp;
+    *cap = newcap;
+    return 0;
+}
+
+/*
+ * Индексированная min-куча моментов завершения обслуживания.
+ * В куче лежат только занятые (непустые) стойки, поэтому size — это
+ * поддерживаемое число непустых стоек, а верх кучи — ближайшее завершение.
+ * - heap[k] — номер стойки в k-й позиции кучи
+ * - pos[d]  — позиция стойки d в heap или -1, если стойка пуста
+ * - key[d]  — время завершения обслуживания текущего пассажира стойки d
+ * Вставка, изменение ключа и удаление стоят O(log N).
+ */
+typedef struct {
+    int* heap;
+    int* pos;
+    int* key;
+    int  size;
+} finish_heap_t;
+
+static int finish_heap_init(finish_heap_t* h, int N) {
+    h->heap = malloc(N * sizeof(int));
+    h->pos  = malloc(N * sizeof(int));
+    h->key  = malloc(N * sizeof(int));
+    if (!h->heap || !h->pos || !h->key) {
+        free(h->heap);
+        free(h->pos);
+        free(h->key);
+        return -1;
+    }
+    for (int i = 0; i < N; i++) {
+        h->pos[i] = -1;
+        h->key[i] = INF_TIME;
+    }
+    h->size = 0;
+    return 0;
+}
+
+static void finish_heap_destroy(finish_heap_t* h) {
+    free(h->heap);
+    free(h->pos);
+    free(h->key);
+}
+
+/* Меньше ли стойка a стойки b: по времени, при равенстве — по номеру */
+static int finish_heap_less(const finish_heap_t* h, int a, int b) {
+    return h->key[a] < h->key[b] || (h->key[a] == h->key[b] && a < b);
+}
+
+static void finish_heap_place(finish_heap_t* h, int k, int d) {
+    h->heap[k] = d;
+    h->pos[d] = k;
+}
+
+static void finish_heap_sift_up(finish_heap_t* h, int k) {
+    int d = h->heap[k];
+    while (k > 0) {
+        int parent = (k - 1) / 2;
+        if (!finish_heap_less(h, d, h->heap[parent])) break;
+        finish_heap_place(h, k, h->heap[parent]);
+        k = parent;
+    }
+    finish_heap_place(h, k, d);
+}
+
+static void finish_heap_sift_down(finish_heap_t* h, int k) {
+    int d = h->heap[k];
+    for (;;) {
+        int child = 2 * k + 1;
+        if (child >= h->size) break;
+        if (child + 1 < h->size && finish_heap_less(h, h->heap[child + 1], h->heap[child])) {
+            child++;
+        }
+        if (!finish_heap_less(h, h->heap[child], d)) break;
+        finish_heap_place(h, k, h->heap[child]);
+        k = child;
+    }
+    finish_heap_place(h, k, d);
+}
+
+/* Вставляет стойку d или меняет её ключ (decrease/increase-key) */
+static void finish_heap_set(finish_heap_t* h, int d, int time) {
+    int k = h->pos[d];
+    if (k < 0) {
+        k = h->size++;
+        h->key[d] = time;
+        finish_heap_place(h, k, d);
+        finish_heap_sift_up(h, k);
+        return;
+    }
+    int old = h->key[d];
+    h->key[d] = time;
+    if (time < old) finish_heap_sift_up(h, k);
+    else            finish_heap_sift_down(h, k);
+}
+
+/* Убирает стойку d из кучи (стойка опустела) */
+static void finish_heap_remove(finish_heap_t* h, int d) {
+    int k = h->pos[d];
+    if (k < 0) return;
+    h->pos[d] = -1;
+    h->key[d] = INF_TIME;
+    int last = h->heap[--h->size];
+    if (k == h->size) return;
+    finish_heap_place(h, k, last);
+    finish_heap_sift_up(h, k);
+    finish_heap_sift_down(h, h->pos[last]);
+}
+
+/* Время ближайшего завершения или INF_TIME, если все стойки пусты */
+static int finish_heap_top_time(const finish_heap_t* h) {
+    return h->size ? h->key[h->heap[0]] : INF_TIME;
+}
+
+
+
+// ----- Политики выбора стойки ----- //
+
+static const char* const policy_names[SIM_POLICY_COUNT] = {
+    [SIM_POLICY_POWER_OF_D]  = "power-of-d",
+    [SIM_POLICY_JSQ]         = "jsq",
+    [SIM_POLICY_LEAST_WORK]  = "least-work",
+    [SIM_POLICY_ROUND_ROBIN] = "round-robin",
+};
+
+const char* sim_policy_name(sim_policy_t policy) {
+    if ((unsigned)policy >= SIM_POLICY_COUNT) return NULL;
+    return policy_names[policy];
+}
+
+int sim_policy_from_name(const char* name, sim_policy_t* out) {
+    for (int p = 0; p < SIM_POLICY_COUNT; p++) {
+        if (strcmp(name, policy_names[p]) == 0) {
+            *out = (sim_policy_t)p;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static const char* const overflow_names[SIM_OVERFLOW_COUNT] = {
+    [SIM_OVERFLOW_REJECT]       = "reject",
+    [SIM_OVERFLOW_REDIRECT]     = "redirect",
+    [SIM_OVERFLOW_SPILL]        = "spill",
+    [SIM_OVERFLOW_BACKPRESSURE] = "backpressure",
+};
+
+const char* sim_overflow_name(sim_overflow_t overflow) {
+    if ((unsigned)overflow >= SIM_OVERFLOW_COUNT) return NULL;
+    return overflow_names[overflow];
+}
+
+int sim_overflow_from_name(const char* name, sim_overflow_t* out) {
+    for (int p = 0; p < SIM_OVERFLOW_COUNT; p++) {
+        if (strcmp(name, overflow_names[p]) == 0) {
+            *out = (sim_overflow_t)p;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static const char* const events_format_names[SIM_EVENTS_COUNT] = {
+    [SIM_EVENTS_NONE]   = "none",
+    [SIM_EVENTS_CSV]    = "csv",
+    [SIM_EVENTS_JSONL]  = "jsonl",
+    [SIM_EVENTS_BINARY] = "binary",
+};
+
+const char* sim_events_format_name(sim_events_format_t format) {
+    if ((unsigned)format >= SIM_EVENTS_COUNT) return NULL;
+    return events_format_names[format];
+}
+
+int sim_events_format_from_name(const char* name, sim_events_format_t* out) {
+    for (int f = 0; f < SIM_EVENTS_COUNT; f++) {
+        if (strcmp(name, events_format_names[f]) == 0) {
+            *out = (sim_events_format_t)f;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Состояние диспетчера. Длины очередей и моменты освобождения стоек лежат
+ * в сплошных массивах int, чтобы полный просмотр (JSQ, least-work) шёл
+ * по памяти подряд и векторизовался.
+ * - len[d]      — длина очереди стойки d
+ * - work_end[d] — момент, когда стойка d разберёт всю очередь, если новых
+ *                 пассажиров не будет; оставшаяся работа = max(work_end[d] - t, 0)
+ */
+typedef struct {
+    sim_policy_t policy;
+    int          N;
+    int          choices;
+    int          next_rr;
+    int*         len;
+    int*         work_end;
+} dispatcher_t;
+
+static int dispatcher_init(dispatcher_t* ds, const sim_config_t* cfg, int N) {
+    ds->policy = cfg->policy;
+    ds->N = N;
+    ds->choices = cfg->choices;
+    if (ds->choices < 1) ds->choices = 1;
+    if (ds->choices > N) ds->choices = N;
+    if (ds->choices > SIM_MAX_CHOICES) ds->choices = SIM_MAX_CHOICES;
+    ds->next_rr = 0;
+    ds->len = calloc(N, sizeof(int));
+    ds->work_end = calloc(N, sizeof(int));
+    if (!ds->len || !ds->work_end) {
+        free(ds->len);
+        free(ds->work_end);
+        return -1;
+    }
+    return 0;
+}
+
+static void dispatcher_destroy(dispatcher_t* ds) {
+    free(ds->len);
+    free(ds->work_end);
+}
+
+/*
+ * Номер наименьшего из max(a[i], floor), i < n; при равенстве — меньший номер.
+ * Значение floor меньше не бывает, поэтому первое такое возвращается сразу
+ * (свободная стойка обычно находится в начале). Иначе первый проход ищет
+ * минимум, второй — его первое вхождение. SSE2 обрабатывает по 4 значения;
+ * min_epi32 в SSE2 нет, поэтому выбор через маску сравнения.
+ */
+static int argmin_floor(const int* a, int n, int floor) {
+    int best = INT_MAX;
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128i vfloor = _mm_set1_epi32(floor);
+    __m128i vmin = _mm_set1_epi32(INT_MAX);
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(a + i));
+        // v <= floor — это не (v > floor); floor + 1 переполнился бы при INT_MAX
+        int mask = ~_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(v, vfloor))) & 0xF;
+        if (mask) return i + __builtin_ctz((unsigned)mask);
+        __m128i lt = _mm_cmplt_epi32(v, vmin);
+        vmin = _mm_or_si128(_mm_and_si128(lt, v), _mm_andnot_si128(lt, vmin));
+    }
+    int lanes[4];
+    _mm_storeu_si128((__m128i*)lanes, vmin);
+    for (int k = 0; k < 4; k++) {
+        if (lanes[k] < best) best = lanes[k];
+    }
+#endif
+    for (; i < n; i++) {
+        if (a[i] <= floor) return i;
+        if (a[i] < best) best = a[i];
+    }
+
+    // Все значения больше floor — ищем первое вхождение минимума
+    i = 0;
+#if defined(__SSE2__)
+    const __m128i vbest = _mm_set1_epi32(best);
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(a + i));
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, vbest)));
+        if (mask) return i + __builtin_ctz((unsigned)mask);
+    }
+#endif
+    for (; i < n; i++) {
+        if (a[i] == best) return i;
+    }
+    return 0;
+}
+
+/*
+ * Power-of-d: d разных стоек равномерно, по одному вызову генератора на каждую
+ * (k-я выбирается из N-k ещё не взятых и сдвигается за уже взятые).
+ * Из них — самая короткая очередь, при равенстве — выбранная раньше.
+ */
+static int choose_power_of_d(const dispatcher_t* ds, rng_t* rng) {
+    int sorted[SIM_MAX_CHOICES];
+    int best = -1;
+    for (int k = 0; k < ds->choices; k++) {
+        int r = (int)rng_bounded(rng, (uint32_t)(ds->N - k));
+        int pos = 0;
+        while (pos < k && sorted[pos] <= r) { r++; pos++; }
+        memmove(&sorted[pos + 1], &sorted[pos], (size_t)(k - pos) * sizeof(int));
+        sorted[pos] = r;
+        if (best < 0 || ds->len[r] < ds->len[best]) best = r;
+    }
+    return best;
+}
+
+/* Стойка для пассажира, пришедшего в момент t */
+static int dispatcher_choose(dispatcher_t* ds, int t, rng_t* rng) {
+    switch (ds->policy) {
+    case SIM_POLICY_JSQ:
+        return argmin_floor(ds->len, ds->N, 0);
+    case SIM_POLICY_LEAST_WORK:
+        return argmin_floor(ds->work_end, ds->N, t);
+    case SIM_POLICY_ROUND_ROBIN: {
+        int d = ds->next_rr;
+        ds->next_rr = (d + 1 == ds->N) ? 0 : d + 1;
+        return d;
+    }
+    case SIM_POLICY_POWER_OF_D:
+    default:
+        return choose_power_of_d(ds, rng);
+    }
+}
+
+/*
+ * Стойка со свободным местом для пассажира, которому досталась заполненная:
+ * самая короткая очередь среди всех стоек. Остальные стойки выборки
+ * power-of-d не короче выбранной, поэтому смотреть только на них бесполезно.
+ * -1, если заполнены все.
+ */
+static int dispatcher_redirect(const dispatcher_t* ds, size_t limit) {
+    int best = argmin_floor(ds->len, ds->N, 0);
+    return (size_t)ds->len[best] < limit ? best : -1;
+}
+
+/* Пассажир с временем обслуживания ts встал в очередь стойки d в момент t */
+static void dispatcher_enqueued(dispatcher_t* ds, int d, int t, int ts) {
+    ds->len[d]++;
+    ds->work_end[d] = (ds->work_end[d] > t ? ds->work_end[d] : t) + ts;
+}
+
+static void dispatcher_dequeued(dispatcher_t* ds, int d) {
+    ds->len[d]--;
+}
+
+
+
+ // ----- SIMULATION SIMULATION SIMULATION SIMULATION SIMULATION SIMULATION SIMULATION SIMULATION ----- //
+
+/*
+ * Снимок стойки: начиная с момента times[col] её очередь — это
+ * отрезок журнала log[head..tail). Снимок пишется только для стоек,
+ * изменившихся в этот момент; до первого снимка стойка пуста.
+ */
+typedef struct {
+    size_t col;
+    size_t head;
+    size_t tail;
+} desk_snap_t;
+
+/*
+ * Журнал стойки: все когда-либо поставленные в неё пассажиры по порядку
+ * (индексы в arrivals). Очередь FIFO, поэтому её содержимое в любой момент —
+ * непрерывный отрезок журнала, и снимок стоит O(1) вместо копирования id.
+ */
+typedef struct {
+    size_t*      log;
+    size_t       tail;    // длина журнала = число постановок в очередь
+    size_t       cap;
+    size_t       head;    // число обслуженных пассажиров
+    size_t       chars;   // суммарная длина id, стоящих в очереди сейчас
+    desk_snap_t* snaps;
+    size_t       nsnaps;
+    size_t       snaps_cap;
+    int          width;   // ширина последнего снимка
+    size_t       served;  // обслужено пассажиров
+    int          dirty;   // стойка менялась в текущий момент
+} desk_log_t;
+
+/* Дописывает пассажира idx в журнал стойки. 0 или -1 при ошибке realloc */
+static int desk_log_push(desk_log_t* d, size_t idx, int id_len) {
+    if (reserve((void**)&d->log, &d->cap, d->tail + 1, sizeof(size_t)) < 0) return -1;
+    d->log[d->tail++] = idx;
+    d->chars += (size_t)id_len;
+    return 0;
+}
+
+/*
+ * Общая очередь ожидания для overflow spill: индексы пассажиров в arrivals
+ * (по ним же доступны ta и ts) в кольце фиксированной ёмкости.
+ */
+typedef struct {
+    size_t* idx;
+    size_t  cap;
+    size_t  head;
+    size_t  count;
+} spill_queue_t;
+
+/* Ширина строки-снимка "id id ... id" (или "-") для отрезка с chars символами id */
+static int snapshot_width(size_t count, size_t chars) {
+    return count ? (int)(chars + count - 1) : 1;
+}
+
+/*
+ * Десятичная запись модуля u в buf (без '\0'), со знаком '-' при neg;
+ * возвращает длину (не больше 21). Общая для моментов, номеров и размеров.
+ */
+static int format_dec(char* buf, unsigned long long u, int neg) {
+    char tmp[20];
+    int n = 0;
+    do {
+        tmp[n++] = (char)('0' + u % 10);
+        u /= 10;
+    } while (u);
+    int len = 0;
+    if (neg) buf[len++] = '-';
+    while (n) buf[len++] = tmp[--n];
+    return len;
+}
+
+static inline int format_int(char buf[12], int v) {
+    return format_dec(buf, v < 0 ? 0ull - (unsigned long long)v : (unsigned long long)v, v < 0);
+}
+
+/*
+ * Буфер вывода таблицы: ячейки собираются прямо в памяти (memcpy id,
+ * memset отступов) и уходят в поток крупными fwrite вместо printf на ячейку.
+ */
+typedef struct {
+    FILE*  out;
+    char*  buf;
+    size_t cap;
+    size_t len;
+    size_t gen;  // число сбросов: смещение в buf действительно, пока gen не сменился
+} out_buf_t;
+
+static void ob_flush(out_buf_t* ob) {
+    if (ob->len) fwrite(ob->buf, 1, ob->len, ob->out);
+    ob->len = 0;
+    ob->gen++;
+}
+
+/* Свободное место под n (<= cap) байт; при нехватке буфер сбрасывается */
+static inline char* ob_room(out_buf_t* ob, size_t n) {
+    if (ob->len + n > ob->cap) ob_flush(ob);
+    return ob->buf + ob->len;
+}
+
+static void ob_write(out_buf_t* ob, const char* s, size_t n) {
+    if (n > ob->cap) {
+        ob_flush(ob);
+        fwrite(s, 1, n, ob->out);
+        return;
+    }
+    memcpy(ob_room(ob, n), s, n);
+    ob->len += n;
+}
+
+static void ob_fill(out_buf_t* ob, char c, size_t n) {
+    while (n) {
+        size_t k = n < ob->cap ? n : ob->cap;
+        memset(ob_room(ob, k), c, k);
+        ob->len += k;
+        n -= k;
+    }
+}
+
+#define EVENT_REC_MAX 256  // наибольшая запись журнала: id в JSON — до 6 байт на символ
+
+static const char* const event_kind_names[] = {
+    [SIM_EVENT_ARRIVAL]   = "arrival",
+    [SIM_EVENT_DEPARTURE] = "departure",
+    [SIM_EVENT_REJECT]    = "reject",
+};
+
+/* Журнал событий прогона: формат и буфер вывода */
+typedef struct {
+    sim_events_format_t fmt;
+    out_buf_t           ob;
+} event_log_t;
+
+/* Готовит буфер и пишет заголовок формата. 0 или -1 при ошибке malloc */
+static int event_log_open(event_log_t* ev, sim_events_format_t fmt, FILE* out) {
+    ev->fmt = fmt;
+    ev->ob = (out_buf_t){ out, malloc(OUT_BUF_SIZE), OUT_BUF_SIZE, 0, 0 };
+    if (!ev->ob.buf) return -1;
+    if (fmt == SIM_EVENTS_CSV)    ob_write(&ev->ob, "time,desk,event,id,queue\n", 25);
+    if (fmt == SIM_EVENTS_BINARY) ob_write(&ev->ob, "QEVLOG1", 8);  // вместе с '\0'
+    return 0;
+}
+
+static void event_log_close(event_log_t* ev) {
+    ob_flush(&ev->ob);
+    fflush(ev->ob.out);
+    free(ev->ob.buf);
+}
+
+static inline char* put_le32(char* p, uint32_t v) {
+    p[0] = (char)(v & 0xff);
+    p[1] = (char)((v >> 8) & 0xff);
+    p[2] = (char)((v >> 16) & 0xff);
+    p[3] = (char)(v >> 24);
+    return p + 4;
+}
+
+/* id в поле CSV: в кавычках (с удвоением кавычек), только если в нём есть , " или перевод строки */
+static char* put_csv_id(char* p, const char* id, int len) {
+    if (!memchr(id, ',', (size_t)len) && !memchr(id, '"', (size_t)len) && !memchr(id, '\n', (size_t)len)) {
+        memcpy(p, id, (size_t)len);
+        return p + len;
+    }
+    *p++ = '"';
+    for (int k = 0; k < len; k++) {
+        if (id[k] == '"') *p++ = '"';
+        *p++ = id[k];
+    }
+    *p++ = '"';
+    return p;
+}
+
+/* id как строка JSON (с кавычками и экранированием) */
+static char* put_json_id(char* p, const char* id, int len) {
+    static const char hex[] = "0123456789abcdef";
+    *p++ = '"';
+    for (int k = 0; k < len; k++) {
+        unsigned char c = (unsigned char)id[k];
+        if (c == '"' || c == '\\') {
+            *p++ = '\\';
+            *p++ = (char)c;
+        } else if (c < 0x20) {
+            memcpy(p, "\\u00", 4);
+            p[4] = hex[c >> 4];
+            p[5] = hex[c & 15];
+            p += 6;
+        } else {
+            *p++ = (char)c;
+        }
+    }
+    *p++ = '"';
+    return p;
+}
+
+/* Пишет событие: момент t, стойка desk (с 0), пассажир p, длина очереди после события */
+static void event_log_write(event_log_t* ev, int t, int desk, sim_event_kind_t kind,
+                            const trace_t* tr, const passenger_t* p, size_t queue) {
+    const char* id = trace_id(tr, p);
+    char* start = ob_room(&ev->ob, EVENT_REC_MAX);
+    char* w = start;
+    switch (ev->fmt) {
+    case SIM_EVENTS_CSV: {
+        size_t klen = strlen(event_kind_names[kind]);
+        w += format_int(w, t);
+        *w++ = ',';
+        w += format_int(w, desk + 1);
+        *w++ = ',';
+        memcpy(w, event_kind_names[kind], klen);
+        w += klen;
+        *w++ = ',';
+        w = put_csv_id(w, id, p->id_len);
+        *w++ = ',';
+        w += format_dec(w, queue, 0);
+        *w++ = '\n';
+        break;
+    }
+    case SIM_EVENTS_JSONL: {
+        size_t klen = strlen(event_kind_names[kind]);
+        memcpy(w, "{\"time\":", 8);
+        w += 8;
+        w += format_int(w, t);
+        memcpy(w, ",\"desk\":", 8);
+        w += 8;
+        w += format_int(w, desk + 1);
+        memcpy(w, ",\"event\":\"", 10);
+        w += 10;
+        memcpy(w, event_kind_names[kind], klen);
+        w += klen;
+        memcpy(w, "\",\"id\":", 7);
+        w += 7;
+        w = put_json_id(w, id, p->id_len);
+        memcpy(w, ",\"queue\":", 9);
+        w += 9;
+        w += format_dec(w, queue, 0);
+        *w++ = '}';
+        *w++ = '\n';
+        break;
+    }
+    case SIM_EVENTS_BINARY:
+        w = put_le32(w, (uint32_t)t);
+        w = put_le32(w, (uint32_t)(desk + 1));
+        w = put_le32(w, (uint32_t)queue);
+        *w++ = (char)kind;
+        *w++ = (char)p->id_len;
+        memcpy(w, id, (size_t)p->id_len);
+        w += p->id_len;
+        break;
+    default:
+        break;
+    }
+    ev->ob.len += (size_t)(w - start);
+}
+
+/*
+ * Результат прогона: моменты времени и журналы стоек со снимками.
+ * id не копируются — таблица ссылается на записи и буфер трассы.
+ * Столбцы делятся на блоки по block штук; ширина столбца своя у каждого
+ * блока и считается по ходу прогона. При out != NULL готовый блок сразу
+ * печатается, а его моменты и снимки освобождаются — в times остаются
+ * только столбцы с номера col_base.
+ */
+struct sim_table {
+    const trace_t* tr;
+    int            N;
+    int*           times;
+    size_t         times_count;
+    size_t         times_cap;
+    size_t         col_base;     // номер столбца times[0]
+    desk_log_t*    logs;
+    int            label_width;  // ширина столбца "№i"
+    int            col_width;    // ширина самого широкого снимка или момента текущего блока
+    size_t         block;        // столбцов в блоке (0 — один блок на всю таблицу)
+    int*           blk_width;    // col_width закрытых, но не напечатанных блоков
+    size_t         nblk;
+    size_t         blk_cap;
+    out_buf_t      ob;           // буфер потоковой печати (ob.out == NULL — не печатать)
+};
+
+/* Число снимков стойки со столбцом не позже c (снимки упорядочены по col) */
+static size_t snap_upper(const desk_log_t* d, size_t c) {
+    size_t lo = 0, hi = d->nsnaps;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (d->snaps[mid].col <= c) lo = mid + 1;
+        else                        hi = mid;
+    }
+    return lo;
+}
+
+/* Пишет снимок — id отрезка log[head..tail) через пробел или "-" — с дополнением до width */
+static void render_snapshot(char* p, const trace_t* tr, const desk_log_t* d, const desk_snap_t* s, size_t width) {
+    char* end = p + width;
+    if (!s || s->head == s->tail) {
+        *p++ = '-';
+    } else {
+        for (size_t k = s->head; k < s->tail; k++) {
+            const passenger_t* q = &tr->items[d->log[k]];
+            if (k > s->head) *p++ = ' ';
+            memcpy(p, trace_id(tr, q), (size_t)q->id_len);
+            p += q->id_len;
+        }
+    }
+    memset(p, ' ', (size_t)(end - p));
+}
+
+/* То же для ячейки шире буфера: по частям */
+static void write_snapshot(out_buf_t* ob, const trace_t* tr, const desk_log_t* d, const desk_snap_t* s, size_t width) {
+    size_t len = 1;
+    if (!s || s->head == s->tail) {
+        ob_write(ob, "-", 1);
+    } else {
+        len = 0;
+        for (size_t k = s->head; k < s->tail; k++) {
+            const passenger_t* q = &tr->items[d->log[k]];
+            if (k > s->head) { ob_write(ob, " ", 1); len++; }
+            ob_write(ob, trace_id(tr, q), (size_t)q->id_len);
+            len += (size_t)q->id_len;
+        }
+    }
+    ob_fill(ob, ' ', width - len);
+}
+
+/*
+ * Печатает столбцы [c0, c1) таблицы шириной col_width + 2: строку моментов
+ * и по строке на стойку. Блок после первого отделяется пустой строкой.
+ */
+static void table_render(out_buf_t* ob, const sim_table_t* table, size_t c0, size_t c1, int col_width) {
+    size_t width = (size_t)col_width + 2;
+    if (c0 > 0) ob_write(ob, "\n", 1);
+
+    // Первая строка: отступ label_width - 2, потом моменты
+    ob_fill(ob, ' ', (size_t)table->label_width - 2);
+    for (size_t c = c0; c < c1; c++) {
+        char num[12];
+        int len = format_int(num, table->times[c - table->col_base]);
+        ob_write(ob, num, (size_t)len);
+        ob_fill(ob, ' ', width - (size_t)len);
+    }
+    ob_write(ob, "\n", 1);
+
+    // Далее N строк: "№i" + состояние очереди i в эти моменты.
+    // Снимок, не менявшийся с прошлого столбца, копируется из уже собранной ячейки.
+    for (int i = 0; i < table->N; i++) {
+        const desk_log_t* d = &table->logs[i];
+        char label[16];
+        int len = snprintf(label, sizeof(label), "№%d", i + 1);
+        ob_write(ob, label, (size_t)len);
+        ob_fill(ob, ' ', (size_t)(table->label_width - len));
+
+        size_t r = snap_upper(d, c0);
+        const desk_snap_t* cur = r ? &d->snaps[r - 1] : NULL;
+        const desk_snap_t* prev = NULL;
+        size_t prev_off = 0, prev_gen = 0;
+        for (size_t c = c0; c < c1; c++) {
+            while (r < d->nsnaps && d->snaps[r].col <= c) cur = &d->snaps[r++];
+            if (width > ob->cap) {
+                write_snapshot(ob, table->tr, d, cur, width);
+                continue;
+            }
+            char* p = ob_room(ob, width);
+            if (prev && cur == prev && prev_gen == ob->gen) memcpy(p, ob->buf + prev_off, width);
+            else                                              render_snapshot(p, table->tr, d, cur, width);
+            prev = cur;
+            prev_off = ob->len;
+            prev_gen = ob->gen;
+            ob->len += width;
+        }
+        ob_write(ob, "\n", 1);
+    }
+}
+
+/*
+ * Закрывает текущий блок столбцов: печатает его сразу (потоковый режим)
+ * или запоминает его ширину до sim_table_print. Ширина следующего блока
+ * начинается с самых широких снимков, которые перейдут в него.
+ * 0 или -1 при ошибке realloc.
+ */
+static int table_close_block(sim_table_t* table) {
+    if (table->ob.out) {
+        size_t c1 = table->col_base + table->times_count;
+        table_render(&table->ob, table, table->col_base, c1, table->col_width);
+        ob_flush(&table->ob);
+        fflush(table->ob.out);
+        table->col_base = c1;
+        table->times_count = 0;
+        // Напечатанное не нужно: у стойки остаётся последний снимок, журнал сжимается до него
+        for (int i = 0; i < table->N; i++) {
+            desk_log_t* d = &table->logs[i];
+            if (!d->nsnaps) continue;
+            d->snaps[0] = d->snaps[d->nsnaps - 1];
+            d->nsnaps = 1;
+            size_t base = d->snaps[0].head;
+            if (base >= LOG_COMPACT_MIN && base * 2 >= d->tail) {
+                memmove(d->log, d->log + base, (d->tail - base) * sizeof(size_t));
+                d->tail -= base;
+                d->head -= base;
+                d->snaps[0].head -= base;
+                d->snaps[0].tail -= base;
+            }
+        }
+    } else {
+        if (reserve((void**)&table->blk_width, &table->blk_cap, table->nblk + 1, sizeof(int)) < 0) return -1;
+        table->blk_width[table->nblk++] = table->col_width;
+    }
+    int w = 1;
+    for (int i = 0; i < table->N; i++) {
+        if (table->logs[i].nsnaps && table->logs[i].width > w) w = table->logs[i].width;
+    }
+    table->col_width = w;
+    return 0;
+}
+
+/* Монотонное время в секундах (для профилирования этапов) */
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+void sim_config_init(sim_config_t* cfg) {
+    cfg->backend = queue_default_backend();
+    cfg->profile = 0;
+    cfg->seed    = 1;
+    cfg->policy  = SIM_POLICY_POWER_OF_D;
+    cfg->choices = 2;
+    cfg->metrics = NULL;
+    cfg->queue_limit = 0;
+    cfg->overflow    = SIM_OVERFLOW_REJECT;
+    cfg->spill_limit = 0;
+    cfg->table_block = 0;
+    cfg->table_out   = NULL;
+    cfg->events      = SIM_EVENTS_NONE;
+    cfg->events_out  = NULL;
+    cfg->on_event    = NULL;
+    cfg->event_ctx   = NULL;
+    cfg->table       = 0;
+}
+
+int sim_metrics_init(sim_metrics_t* m, int N) {
+    memset(m, 0, sizeof(*m));
+    hist_init(&m->wait);
+    hist_init(&m->sojourn);
+    m->busy = calloc(N > 0 ? N : 1, sizeof(int64_t));
+    if (!m->busy) return -1;
+    m->N = N;
+    return 0;
+}
+
+void sim_metrics_free(sim_metrics_t* m) {
+    free(m->busy);
+    m->busy = NULL;
+}
+
+double sim_metrics_utilization(const sim_metrics_t* m, int d) {
+    int span = m->makespan - m->first_arrival;
+    return span > 0 ? (double)m->busy[d] / (double)span : 0.0;
+}
+
+static void print_latency(const char* name, const hist_t* h, FILE* out) {
+    fprintf(out, "%-9s %10.2f %8d %8d %8d %8d %8d\n", name, hist_mean(h),
+            hist_quantile(h, 0.50), hist_quantile(h, 0.90), hist_quantile(h, 0.99),
+            hist_quantile(h, 0.999), h->total ? h->max : 0);
+}
+
+void sim_metrics_print(const sim_metrics_t* m, FILE* out) {
+    fprintf(out, "served: %llu, rejected: %zu, time: %d..%d\n",
+            (unsigned long long)m->wait.total, m->rejected, m->first_arrival, m->makespan);
+    if (m->queue_limit) {
+        fprintf(out, "overflow: %s, limit %zu per desk, redirected: %zu, spilled: %zu, held: %zu\n",
+                sim_overflow_name(m->overflow), m->queue_limit, m->redirected, m->spilled, m->held);
+    }
+    fprintf(out, "%-9s %10s %8s %8s %8s %8s %8s\n", "latency", "mean", "p50", "p90", "p99", "p99.9", "max");
+    print_latency("wait", &m->wait, out);
+    print_latency("sojourn", &m->sojourn, out);
+
+    double sum = 0.0, lo = 0.0, hi = 0.0;
+    for (int d = 0; d < m->N; d++) {
+        double u = sim_metrics_utilization(m, d);
+        sum += u;
+        if (d == 0 || u < lo) lo = u;
+        if (d == 0 || u > hi) hi = u;
+    }
+    fprintf(out, "utilization: mean %.4f, min %.4f, max %.4f\n", m->N ? sum / m->N : 0.0, lo, hi);
+    for (int d = 0; d < m->N; d++) {
+        char label[16];
+        snprintf(label, sizeof(label), "№%d", d + 1);
+        fprintf(out, "%-8s %.4f\n", label, sim_metrics_utilization(m, d));
+    }
+}
+
+void sim_table_free(sim_table_t* table) {
+    if (!table) return;
+    if (table->logs) {
+        for (int i = 0; i < table->N; i++) {
+            free(table->logs[i].log);
+            free(table->logs[i].snaps);
+        }
+    }
+    free(table->logs);
+    free(table->times);
+    free(table->blk_width);
+    free(table->ob.buf);
+    free(table);
+}
+
+/*
+ * Прогон: очереди стоек, куча завершений, журналы стоек и счётчики.
+ * Пассажиры берутся из трассы tr — чужой (sim_run) или своей own,
+ * в которую дописывает sim_add_arrival.
+ */
+struct sim {
+    sim_config_t   cfg;
+    int            N;
+    trace_t*       tr;
+    trace_t        own;          // записи sim_add_arrival
+    size_t         own_cap;      // ёмкость own.data
+    size_t         limit;        // наибольшая длина очереди стойки (0 — без ограничения)
+    queue_pool_t*  pool;
+    queue_t**      desks;
+    finish_heap_t  finish;
+    int*           finishing;
+    dispatcher_t   disp;
+    desk_log_t*    logs;         // при записи снимков принадлежат таблице
+    int*           touched;      // стойки, изменившиеся в текущий момент
+    int            n_touched;
+    sim_table_t*   table;
+    spill_queue_t  spill;
+    int            blocked;      // backpressure: приходы придержаны до ближайшего ухода
+    size_t         held_idx;     // последний придержанный пассажир (считается один раз)
+    event_log_t    ev_log;
+    event_log_t*   ev;
+    int            emit;         // есть журнал или on_event
+    rng_t          rng;          // своё состояние: прогоны независимы и воспроизводимы
+    sim_stats_t    st;
+    double         wait_sum;
+    size_t         started;      // пассажиров, дошедших до обслуживания
+    size_t         i_arr;        // первый ещё не пришедший пассажир
+    size_t         trim_at;      // own: при каком i_arr сжимать записи
+    int            t;            // момент последнего обработанного события
+    int            changed;      // в момент t что-то изменилось, снимок ещё не записан
+    int            horizon;      // прогон продвинут до этого момента включительно
+    int            have_first;
+    int            first_ta;     // момент первого прихода
+    int            failed;
+};
+
+/* Передаёт событие журналу и on_event */
+static void sim_emit(sim_t* s, int t, int desk, sim_event_kind_t kind, const passenger_t* p, size_t queue) {
+    if (s->ev) event_log_write(s->ev, t, desk, kind, s->tr, p, queue);
+    if (s->cfg.on_event) {
+        sim_event_t e = { t, desk, kind, trace_id(s->tr, p), (size_t)p->id_len, queue };
+        s->cfg.on_event(&e, s->cfg.event_ctx);
+    }
+}
+
+/*
+ * Создаёт прогон над трассой tr (NULL — своя, для sim_add_arrival).
+ * record — записывать снимки для таблицы. NULL при ошибке (сообщение в stderr).
+ */
+static sim_t* sim_new(const sim_config_t* cfg, int N, trace_t* tr, int record) {
+    if (N < 1) {
+        fprintf(stderr, "Error: at least 1 desk is required, but N=%d\n", N);
+        return NULL;
+    }
+    if (cfg->metrics && cfg->metrics->N != N) {
+        fprintf(stderr, "Error: metrics prepared for %d desks, but N=%d\n", cfg->metrics->N, N);
+        return NULL;
+    }
+    sim_t* s = calloc(1, sizeof(sim_t));
+    if (!s) {
+        fprintf(stderr, "Error: malloc failed for simulation\n");
+        return NULL;
+    }
+    s->cfg = *cfg;
+    s->N = N;
+    s->tr = tr ? tr : &s->own;
+    s->own.desks = N;
+    s->own.owned = 1;
+    s->held_idx = (size_t)-1;
+    s->changed = 1;  // момент 0 сохраняется всегда
+    s->horizon = INT_MIN;
+    s->trim_at = TRIM_MIN;
+    rng_seed(&s->rng, cfg->seed);
+
+    // Ограничение длины очереди: явное или ёмкость кольцевого буфера array
+    s->limit = cfg->queue_limit;
+    if (!s->limit && cfg->backend == QUEUE_BACKEND_ARRAY) s->limit = DESK_CAPACITY;
+    if (s->limit && cfg->overflow == SIM_OVERFLOW_SPILL) {
+        s->spill.cap = cfg->spill_limit ? cfg->spill_limit : s->limit;
+        s->spill.idx = malloc(s->spill.cap * sizeof(size_t));
+        if (!s->spill.idx) {
+            fprintf(stderr, "Error: malloc failed for spill queue\n");
+            sim_destroy(s);
+            return NULL;
+        }
+    }
+
+    // 1) N очередей на общем пуле записей
+    s->pool = queue_pool_create();
+    s->desks = calloc(N, sizeof(queue_t*));
+    if (!s->pool || !s->desks) {
+        fprintf(stderr, "Error: malloc failed for desks array\n");
+        sim_destroy(s);
+        return NULL;
+    }
+    for (int i = 0; i < N; i++) {
+        s->desks[i] = queue_create_pooled(cfg->backend, s->limit ? s->limit : DESK_CAPACITY, s->pool);
+        if (!s->desks[i]) {
+            fprintf(stderr, "Error: failed to create queue %d\n", i);
+            sim_destroy(s);
+            return NULL;
+        }
+    }
+
+    // 2) Куча завершений: пока никто не обслуживается, она пуста
+    s->finishing = malloc(N * sizeof(int));
+    if (!s->finishing || finish_heap_init(&s->finish, N) < 0) {
+        fprintf(stderr, "Error: malloc failed for finish heap\n");
+        sim_destroy(s);
+        return NULL;
+    }
+    if (dispatcher_init(&s->disp, cfg, N) < 0) {
+        fprintf(stderr, "Error: malloc failed for dispatcher\n");
+        sim_destroy(s);
+        return NULL;
+    }
+
+    // 3) Журналы стоек и список стоек, изменившихся в текущий момент. Журналы нужны
+    //    и без таблицы: по ним находится ta пассажира, дошедшего до начала очереди.
+    s->logs = calloc(N, sizeof(desk_log_t));
+    s->touched = malloc(N * sizeof(int));
+    if (!s->logs || !s->touched) {
+        fprintf(stderr, "Error: malloc failed for desk logs\n");
+        sim_destroy(s);
+        return NULL;
+    }
+    if (record) {
+        sim_table_t* table = calloc(1, sizeof(sim_table_t));
+        if (!table) {
+            fprintf(stderr, "Error: malloc failed for desk logs\n");
+            sim_destroy(s);
+            return NULL;
+        }
+        s->table = table;
+        table->tr = s->tr;
+        table->N = N;
+        table->logs = s->logs;
+        table->col_width = 1;
+        table->block = cfg->table_block;
+        // label_width = max длина "№X" + 2 пробела
+        char tmp[16];
+        table->label_width = snprintf(tmp, sizeof(tmp), "№%d", N) + 2;
+        if (table->block && cfg->table_out) {
+            table->ob.out = cfg->table_out;
+            table->ob.cap = OUT_BUF_SIZE;
+            table->ob.buf = malloc(OUT_BUF_SIZE);
+            if (!table->ob.buf) {
+                fprintf(stderr, "Error: malloc failed for output buffer\n");
+                sim_destroy(s);
+                return NULL;
+            }
+        }
+    }
+
+    // 4) Журнал событий пишется по ходу прогона
+    if (cfg->events != SIM_EVENTS_NONE) {
+        if (event_log_open(&s->ev_log, cfg->events, cfg->events_out ? cfg->events_out : stdout) < 0) {
+            fprintf(stderr, "Error: malloc failed for event log buffer\n");
+            sim_destroy(s);
+            return NULL;
+        }
+        s->ev = &s->ev_log;
+    }
+    s->emit = s->ev || cfg->on_event;
+    return s;
+}
+
+sim_t* sim_create(const sim_config_t* cfg, int desks) {
+    return sim_new(cfg, desks, NULL, cfg->table);
+}
+
+void sim_destroy(sim_t* s) {
+    if (!s) return;
+    sim_metrics_t* mx = s->cfg.metrics;
+    if (mx && s->desks) {
+        mx->first_arrival = s->first_ta;
+        mx->makespan = s->st.makespan;
+        mx->rejected += s->st.rejected;
+        mx->queue_limit = s->limit;
+        mx->overflow = s->cfg.overflow;
+        mx->redirected += s->st.redirected;
+        mx->spilled += s->st.spilled;
+        mx->held += s->st.held;
+    }
+    if (s->ev) event_log_close(s->ev);
+    if (s->table) {
+        sim_table_free(s->table);  // вместе с журналами
+    } else if (s->logs) {
+        for (int i = 0; i < s->N; i++) {
+            free(s->logs[i].log);
+            free(s->logs[i].snaps);
+        }
+        free(s->logs);
+    }
+    if (s->desks) {
+        for (int i = 0; i < s->N; i++) queue_destroy(s->desks[i]);
+    }
+    queue_pool_destroy(s->pool);
+    free(s->desks);
+    free(s->spill.idx);
+    free(s->touched);
+    dispatcher_destroy(&s->disp);
+    finish_heap_destroy(&s->finish);
+    free(s->finishing);
+    trace_free(&s->own);
+    free(s);
+}
+
+/* Записывает t и отрезки изменившихся в момент s->t стоек. 0 или -1 при ошибке realloc */
+static int sim_snapshot(sim_t* s) {
+    sim_table_t* table = s->table;
+    double snap_start = s->cfg.profile ? now_sec() : 0.0;
+    if (reserve((void**)&table->times, &table->times_cap, table->times_count + 1, sizeof(int)) < 0) {
+        fprintf(stderr, "Error: out of memory after %zu events\n", table->col_base + table->times_count);
+        return -1;
+    }
+    for (int k = 0; k < s->n_touched; k++) {
+        desk_log_t* d = &s->logs[s->touched[k]];
+        d->dirty = 0;
+        if (reserve((void**)&d->snaps, &d->snaps_cap, d->nsnaps + 1, sizeof(desk_snap_t)) < 0) {
+            fprintf(stderr, "Error: malloc failed for snapshot at time %d\n", s->t);
+            return -1;
+        }
+        desk_snap_t* snap = &d->snaps[d->nsnaps++];
+        snap->col  = table->col_base + table->times_count;
+        snap->head = d->head;
+        snap->tail = d->tail;
+        d->width = snapshot_width(d->tail - d->head, d->chars);
+        if (d->width > table->col_width) table->col_width = d->width;
+    }
+    s->n_touched = 0;
+    char num[12];
+    int tw = format_int(num, s->t);
+    if (tw > table->col_width) table->col_width = tw;
+    table->times[table->times_count++] = s->t;
+    if (table->block && (table->col_base + table->times_count) % table->block == 0 &&
+        table_close_block(table) < 0) {
+        fprintf(stderr, "Error: out of memory after %zu events\n", table->col_base + table->times_count);
+        return -1;
+    }
+    if (s->cfg.profile) s->st.snapshot_sec += now_sec() - snap_start;
+    return 0;
+}
+
+/* Пассажир встал к свободной стойке desk в момент t и сразу начал обслуживаться */
+static inline void sim_start_service(sim_t* s, int desk, int t, int ta, int ts) {
+    int wait = t - ta;
+    finish_heap_set(&s->finish, desk, t + ts);
+    s->wait_sum += wait;
+    s->started++;
+    if (wait > s->st.max_wait) s->st.max_wait = wait;
+    if (s->cfg.metrics) {
+        hist_record(&s->cfg.metrics->wait, wait);
+        hist_record(&s->cfg.metrics->sojourn, wait + ts);
+        s->cfg.metrics->busy[desk] += ts;
+    }
+}
+
+/* Отмечает стойку изменившейся в текущий момент (для снимка) */
+static inline void sim_touch(sim_t* s, int desk) {
+    desk_log_t* d = &s->logs[desk];
+    if (s->table && !d->dirty) {
+        d->dirty = 1;
+        s->touched[s->n_touched++] = desk;
+    }
+}
+
+/* Завершения обслуживания в момент t. 0 или -1 при ошибке */
+static int sim_departures(sim_t* s, int t) {
+    const passenger_t* arrivals = s->tr->items;
+    // Сначала снимаем с кучи все стойки с ключом t, затем обрабатываем их
+    // (новый ключ t + 0 попадёт уже в следующее событие)
+    int n_fin = 0;
+    while (s->finish.size > 0 && finish_heap_top_time(&s->finish) == t) {
+        int j = s->finish.heap[0];
+        finish_heap_remove(&s->finish, j);
+        s->finishing[n_fin++] = j;
+    }
+    for (int k = 0; k < n_fin; k++) {
+        int j = s->finishing[k];
+        desk_log_t* d = &s->logs[j];
+        queue_t* q = s->desks[j];
+        queue_dequeue(q);
+        dispatcher_dequeued(&s->disp, j);
+        if (s->emit) sim_emit(s, t, j, SIM_EVENT_DEPARTURE, &arrivals[d->log[d->head]], queue_size(q));
+        d->chars -= (size_t)arrivals[d->log[d->head]].id_len;
+        d->head++;
+        d->served++;
+        s->blocked = 0;  // место освободилось — придержанные приходы пробуют снова
+        if (s->spill.count && (size_t)s->disp.len[j] < s->limit) {
+            // Освободившееся место забирает первый из общей очереди ожидания
+            spill_queue_t* sp = &s->spill;
+            size_t idx = sp->idx[sp->head];
+            const passenger_t* p = &arrivals[idx];
+            sp->head = (sp->head + 1 == sp->cap) ? 0 : sp->head + 1;
+            sp->count--;
+            if (queue_enqueue_n(q, trace_id(s->tr, p), p->id_len, p->ts) < 0) {
+                s->st.rejected++;
+                if (s->emit) sim_emit(s, t, j, SIM_EVENT_REJECT, p, queue_size(q));
+            } else {
+                dispatcher_enqueued(&s->disp, j, t, p->ts);
+                if (s->emit) sim_emit(s, t, j, SIM_EVENT_ARRIVAL, p, queue_size(q));
+                if (desk_log_push(d, idx, p->id_len) < 0) {
+                    fprintf(stderr, "Error: out of memory after reading %zu passengers\n", s->i_arr);
+                    return -1;
+                }
+            }
+        }
+        if (!queue_empty(q)) {
+            sim_start_service(s, j, t, arrivals[d->log[d->head]].ta, queue_front_service_time(q));
+        }
+        if (!s->table && d->head >= LOG_COMPACT_MIN && d->head * 2 >= d->tail) {
+            // Обслуженная часть журнала без таблицы не нужна
+            memmove(d->log, d->log + d->head, (d->tail - d->head) * sizeof(size_t));
+            d->tail -= d->head;
+            d->head = 0;
+        }
+        sim_touch(s, j);
+        s->st.departures++;
+        s->st.makespan = t;
+        s->changed = 1;
+    }
+    return 0;
+}
+
+/* Приходы в момент t (и придержанные backpressure приходы с ta < t). 0 или -1 при ошибке */
+static int sim_arrivals(sim_t* s, int t) {
+    const passenger_t* arrivals = s->tr->items;
+    size_t total = s->tr->count;
+    sim_stats_t* st = &s->st;
+    while (!s->blocked && s->i_arr < total && arrivals[s->i_arr].ta <= t) {
+        size_t idx = s->i_arr;
+        const passenger_t* p = &arrivals[idx];
+        if (!s->have_first) {
+            s->have_first = 1;
+            s->first_ta = p->ta;
+        }
+        int chosen = dispatcher_choose(&s->disp, t, &s->rng);
+        int admit = 1;
+        size_t rejected = st->rejected;
+        if (s->limit && (size_t)s->disp.len[chosen] >= s->limit) {
+            // Стойка заполнена — решает политика переполнения
+            admit = 0;
+            switch (s->cfg.overflow) {
+            case SIM_OVERFLOW_REDIRECT: {
+                int alt = dispatcher_redirect(&s->disp, s->limit);
+                if (alt >= 0) {
+                    chosen = alt;
+                    admit = 1;
+                    st->redirected++;
+                } else {
+                    st->rejected++;
+                }
+                break;
+            }
+            case SIM_OVERFLOW_SPILL: {
+                spill_queue_t* sp = &s->spill;
+                if (sp->count < sp->cap) {
+                    size_t at = sp->head + sp->count;
+                    sp->idx[at >= sp->cap ? at - sp->cap : at] = idx;
+                    sp->count++;
+                    st->spilled++;
+                    if (sp->count > st->max_spill) st->max_spill = sp->count;
+                } else {
+                    st->rejected++;
+                }
+                break;
+            }
+            case SIM_OVERFLOW_BACKPRESSURE:
+                s->blocked = 1;
+                if (s->held_idx != idx) {
+                    s->held_idx = idx;
+                    st->held++;
+                }
+                break;
+            case SIM_OVERFLOW_REJECT:
+            default:
+                st->rejected++;
+                break;
+            }
+            if (s->blocked) break;
+        }
+        s->i_arr++;
+        desk_log_t* d = &s->logs[chosen];
+        queue_t* q = s->desks[chosen];
+        if (admit && queue_enqueue_n(q, trace_id(s->tr, p), p->id_len, p->ts) < 0) {
+            admit = 0;
+            st->rejected++;
+        }
+        if (s->emit && (admit || st->rejected != rejected)) {
+            // Ушедший в общую очередь ожидания попадёт в журнал, когда встанет к стойке
+            sim_emit(s, t, chosen, admit ? SIM_EVENT_ARRIVAL : SIM_EVENT_REJECT, p, queue_size(q));
+        }
+        if (admit) {
+            dispatcher_enqueued(&s->disp, chosen, t, p->ts);
+            if (desk_log_push(d, idx, p->id_len) < 0) {
+                fprintf(stderr, "Error: out of memory after reading %zu passengers\n", idx);
+                return -1;
+            }
+        }
+        size_t len = queue_size(q);
+        if (len > st->max_queue) st->max_queue = len;
+        // Встал к свободной стойке: ожидание 0, если его не придерживали на входе
+        if (admit && len == 1) sim_start_service(s, chosen, t, p->ta, p->ts);
+        sim_touch(s, chosen);
+        st->arrivals++;
+        s->changed = 1;
+    }
+    return 0;
+}
+
+/*
+ * Своя трасса без таблицы (или с потоковой печатью блоков): пришедшие
+ * и уже не нужные записи выбрасываются. Ищется наименьший ещё нужный индекс
+ * (в очередях, в снимках непечатанного блока, общей очереди ожидания
+ * или впереди), записи и id до него выбрасываются, индексы сдвигаются.
+ * Стоит O(пассажиров в системе + снимков блока + N) и делается не чаще
+ * чем раз на столько же приходов.
+ */
+static void sim_trim(sim_t* s) {
+    size_t base = s->i_arr;
+    size_t live = 0;
+    for (int i = 0; i < s->N; i++) {
+        desk_log_t* d = &s->logs[i];
+        // Снимки упорядочены по времени, и самый ранний отрезок начинается раньше всех
+        size_t lo = d->nsnaps && d->snaps[0].head < d->head ? d->snaps[0].head : d->head;
+        for (size_t k = lo; k < d->tail; k++) {
+            if (d->log[k] < base) base = d->log[k];
+        }
+        live += d->tail - lo + d->nsnaps;
+    }
+    for (size_t k = 0; k < s->spill.count; k++) {
+        size_t at = s->spill.head + k;
+        size_t idx = s->spill.idx[at >= s->spill.cap ? at - s->spill.cap : at];
+        if (idx < base) base = idx;
+    }
+    live += s->spill.count + (s->own.count - s->i_arr) + (size_t)s->N;
+    s->trim_at = s->i_arr + (live > TRIM_MIN ? live : TRIM_MIN);
+    if (base == 0) return;
+
+    trace_t* tr = &s->own;
+    size_t off = base < tr->count ? tr->items[base].id_off : tr->size;
+    memmove(tr->items, tr->items + base, (tr->count - base) * sizeof(passenger_t));
+    tr->count -= base;
+    for (size_t k = 0; k < tr->count; k++) tr->items[k].id_off -= off;
+    memmove(tr->data, tr->data + off, tr->size - off);
+    tr->size -= off;
+
+    for (int i = 0; i < s->N; i++) {
+        desk_log_t* d = &s->logs[i];
+        size_t lo = d->nsnaps && d->snaps[0].head < d->head ? d->snaps[0].head : d->head;
+        size_t n = d->tail - lo;
+        for (size_t k = 0; k < n; k++) d->log[k] = d->log[lo + k] - base;
+        d->head -= lo;
+        d->tail = n;
+        for (size_t k = 0; k < d->nsnaps; k++) {
+            d->snaps[k].head -= lo;
+            d->snaps[k].tail -= lo;
+        }
+    }
+    for (size_t k = 0; k < s->spill.count; k++) {
+        size_t at = s->spill.head + k;
+        s->spill.idx[at >= s->spill.cap ? at - s->spill.cap : at] -= base;
+    }
+    s->held_idx = s->held_idx != (size_t)-1 && s->held_idx >= base ? s->held_idx - base : (size_t)-1;
+    s->i_arr -= base;
+    s->trim_at -= base;
+}
+
+/* Продвигает прогон по событиям с моментом не позже until */
+static int sim_run_until(sim_t* s, int until) {
+    if (s->failed) return -1;
+    double start = now_sec();
+    while (!s->failed) {
+        // Если что-то изменилось, сохраняем t и отрезки только изменившихся стоек
+        if (s->changed) {
+            if (s->table && sim_snapshot(s) < 0) {
+                s->failed = 1;
+                break;
+            }
+            s->changed = 0;
+        }
+        int time_next_arr = (s->i_arr < s->tr->count && !s->blocked ? s->tr->items[s->i_arr].ta : INF_TIME);
+        int time_next_fin = finish_heap_top_time(&s->finish);
+        int t = (time_next_arr < time_next_fin ? time_next_arr : time_next_fin);
+        if (t == INF_TIME || t > until) break;
+        s->t = t;
+        if (sim_departures(s, t) < 0 || sim_arrivals(s, t) < 0) s->failed = 1;
+    }
+    if (s->ev) ob_flush(&s->ev->ob);
+    // С таблицей записи нужны для печати, если только блоки не печатаются по ходу
+    if (s->tr == &s->own && (!s->table || s->table->ob.out) && s->i_arr >= s->trim_at) sim_trim(s);
+    s->st.loop_sec += now_sec() - start;
+    return s->failed ? -1 : 0;
+}
+
+int sim_add_arrival(sim_t* s, const char* id, size_t id_len, int ta, int ts) {
+    trace_t* tr = &s->own;
+    if (s->tr != tr) {
+        fprintf(stderr, "Error: simulation is fed from a trace\n");
+        return -1;
+    }
+    if (id_len >= MAX_ID_LEN) {
+        fprintf(stderr, "Error: passenger id is longer than %d characters\n", MAX_ID_LEN - 1);
+        return -1;
+    }
+    if (ts < 0) {
+        fprintf(stderr, "Error: negative service time %d\n", ts);
+        return -1;
+    }
+    int last = tr->count ? tr->items[tr->count - 1].ta : s->horizon;
+    if (ta <= s->horizon || ta < last) {
+        fprintf(stderr, "Error: arrival at %d is earlier than the simulation time %d\n",
+                ta, ta <= s->horizon ? s->horizon : last);
+        return -1;
+    }
+    if (trace_reserve(tr, 1) < 0 || reserve((void**)&tr->data, &s->own_cap, tr->size + id_len, 1) < 0) {
+        fprintf(stderr, "Error: out of memory after %zu passengers\n", tr->count);
+        return -1;
+    }
+    passenger_t* p = &tr->items[tr->count++];
+    p->id_off = tr->size;
+    p->id_len = (int)id_len;
+    p->ta = ta;
+    p->ts = ts;
+    memcpy(tr->data + tr->size, id, id_len);
+    tr->size += id_len;
+    return 0;
+}
+
+int sim_advance_until(sim_t* s, int t) {
+    int rc = sim_run_until(s, t);
+    if (t > s->horizon) s->horizon = t;
+    return rc;
+}
+
+int sim_drain(sim_t* s) {
+    int rc = sim_run_until(s, INT_MAX);
+    if (s->t > s->horizon) s->horizon = s->t;
+    return rc;
+}
+
+int sim_now(const sim_t* s) {
+    return s->t;
+}
+
+int sim_query_desk(const sim_t* s, int desk, sim_desk_state_t* out) {
+    if (desk < 0 || desk >= s->N) return -1;
+    const queue_t* q = s->desks[desk];
+    out->queue = queue_size(q);
+    out->served = s->logs[desk].served;
+    out->busy_until = out->queue ? s->finish.key[desk] : -1;
+    out->front_id = queue_front_id(q);
+    out->front_id_len = out->front_id ? strlen(out->front_id) : 0;
+    return 0;
+}
+
+void sim_get_stats(const sim_t* s, sim_stats_t* stats) {
+    *stats = s->st;
+    if (s->table) stats->columns = s->table->col_base + s->table->times_count;
+    stats->mean_wait = s->started ? s->wait_sum / (double)s->started : 0.0;
+}
+
+const sim_table_t* sim_get_table(const sim_t* s) {
+    return s->table;
+}
+
+int sim_run(const trace_t* tr, const sim_config_t* cfg, sim_table_t** out, sim_stats_t* stats) {
+    // Без feed трасса только читается
+    return sim_run_feed((trace_t*)tr, cfg, NULL, NULL, out, stats);
+}
+
+int sim_run_feed(trace_t* tr, const sim_config_t* cfg, sim_feed_fn feed, void* feed_ctx,
+                 sim_table_t** out, sim_stats_t* stats) {
+    if (out) *out = NULL;
+    sim_t* s = sim_new(cfg, tr->desks, tr, out != NULL);
+    if (!s) return -1;
+    int rc = 0;
+    while (feed) {
+        int more = feed(tr, feed_ctx);
+        if (more < 0) {
+            rc = -2;
+            break;
+        }
+        if (more == 0) break;
+        // Записи с последним полученным ta могут прийти и со следующей порцией
+        if (tr->count && sim_advance_until(s, tr->items[tr->count - 1].ta - 1) < 0) {
+            rc = -1;
+            break;
+        }
+    }
+    if (rc == 0 && sim_drain(s) < 0) rc = -1;
+    if (stats) sim_get_stats(s, stats);
+    if (rc == 0 && out) {
+        // Таблица (с журналами стоек) переходит вызывающему
+        *out = s->table;
+        s->table = NULL;
+        s->logs = NULL;
+    }
+    sim_destroy(s);
+    return rc;
+}
+
+void sim_table_print(const sim_table_t* table, FILE* out) {
+    // Свой буфер: таблица только читается; без памяти — небольшой на стеке
+    char small[4096];
+    out_buf_t ob = { out, malloc(OUT_BUF_SIZE), OUT_BUF_SIZE, 0, 0 };
+    if (!ob.buf) {
+        ob.buf = small;
+        ob.cap = sizeof(small);
+    }
+    size_t c0 = table->col_base;
+    size_t end = c0 + table->times_count;
+    for (size_t b = 0; b < table->nblk; b++) {
+        table_render(&ob, table, c0, c0 + table->block, table->blk_width[b]);
+        c0 += table->block;
+    }
+    // Незакрытый блок (или вся таблица, если блоков нет)
+    if (c0 < end || end == 0) table_render(&ob, table, c0, end, table->col_width);
+    ob_flush(&ob);
+    if (ob.buf != small) free(ob.buf);
+}
+
+void run_simulation(void) {
+    sim_config_t cfg;
+    sim_config_init(&cfg);
+    run_simulation_with(&cfg);
+}
+
+/*
+ * Загружает и разбирает вход из stdin, проверяет N и сортирует записи по ta.
+ * Возвращает 0 или -1 (сообщение уже напечатано, трасса освобождена).
+ */
+static int load_input(trace_t* tr) {
+    // Вход загружается целиком (mmap файла или буфер для канала) и
+    // разбирается без копирования id
+    if (trace_load_stream(tr, stdin) < 0) {
+        fprintf(stderr, "Error: failed to read input\n");
+        return -1;
+    }
+    int rc = trace_parse(tr);
+    if (rc == -1) {
+        fprintf(stderr, "Error: failed to read number of desks\n");
+        trace_free(tr);
+        return -1;
+    }
+    if (rc < 0) {
+        fprintf(stderr, "Error: out of memory after reading %zu passengers\n", tr->count);
+        trace_free(tr);
+        return -1;
+    }
+    if (tr->desks < 2) {
+        fprintf(stderr, "Error: at least 2 desks are required, but N=%d\n", tr->desks);
+        trace_free(tr);
+        return -1;
+    }
+    if (tr->skipped) {
+        fprintf(stderr, "Warning: skipped %zu malformed records (expected id/ta/ts)\n", tr->skipped);
+    }
+    trace_sort(tr);
+    return 0;
+}
+
+void run_simulation_with(const sim_config_t* cfg) {
+    trace_t tr;
+    if (load_input(&tr) < 0) return;
+
+    // Моделируем и печатаем таблицу (блоки столбцов — сразу по готовности)
+    // или только журнал событий: тогда снимки не пишутся
+    sim_config_t run_cfg = *cfg;
+    if (run_cfg.table_block) run_cfg.table_out = stdout;
+    int events = run_cfg.events != SIM_EVENTS_NONE;
+    sim_table_t* table = NULL;
+    sim_stats_t stats;
+    if (sim_run(&tr, &run_cfg, events ? NULL : &table, &stats) == 0) {
+        if (stats.rejected) {
+            fprintf(stderr, "Warning: %zu passengers were rejected by full desk queues\n", stats.rejected);
+        }
+        if (table) {
+            sim_table_print(table, stdout);
+            sim_table_free(table);
+        }
+    }
+    trace_free(&tr);
+}
+
+void run_metrics_with(const sim_config_t* cfg) {
+    trace_t tr;
+    if (load_input(&tr) < 0) return;
+
+    sim_metrics_t metrics;
+    if (sim_metrics_init(&metrics, tr.desks) < 0) {
+        fprintf(stderr, "Error: malloc failed for metrics\n");
+        trace_free(&tr);
+        return;
+    }
+    sim_config_t run_cfg = *cfg;
+    run_cfg.metrics = &metrics;
+    // Таблица не нужна: снимки не пишутся
+    if (sim_run(&tr, &run_cfg, NULL, NULL) == 0) {
+        sim_metrics_print(&metrics, stdout);
+    }
+    sim_metrics_free(&metrics);
+    trace_free(&tr);
+}
+
+void run_replications_with(const sim_config_t* cfg, const sim_replicate_config_t* rc) {
+    trace_t tr;
+    if (load_input(&tr) < 0) return;
+
+    sim_replicate_result_t res;
+    if (sim_replicate(&tr, cfg, rc, &res) == 0) {
+        sim_replicate_print(&res, stdout);
+    }
+    trace_free(&tr);
+}
@@ -0,0 +1,139 @@
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include "spsc_ring.h"
+
+#define CACHE_LINE 64
+#define SPIN_BEFORE_YIELD 64  // холостых проверок перед уступкой процессора
+
+/*
+ * Поля читателя и писателя разнесены по разным строкам кэша, чтобы
+ * запись своего индекса не сбрасывала строку у другой стороны.
+ * Каждая сторона держит кэшированную копию чужого индекса и перечитывает
+ * атомарный индекс, только когда по копии места (или данных) не хватает.
+ */
+struct spsc_ring {
+    // Писатель
+    _Alignas(CACHE_LINE) atomic_size_t tail;  // сколько элементов опубликовано
+    size_t head_cache;                         // последний виденный head
+
+    // Читатель
+    _Alignas(CACHE_LINE) atomic_size_t head;  // сколько элементов забрано
+    size_t tail_cache;                         // последний виденный tail
+
+    // Общие неизменяемые поля и флаг закрытия
+    _Alignas(CACHE_LINE) atomic_int closed;
+    size_t         mask;
+    size_t         elem;
+    unsigned char* buf;
+};
+
+spsc_ring_t* spsc_ring_create(size_t capacity, size_t elem_size) {
+    if (capacity == 0 || elem_size == 0) return NULL;
+    size_t cap = 1;
+    while (cap < capacity) cap *= 2;
+
+    spsc_ring_t* r = aligned_alloc(CACHE_LINE, sizeof(spsc_ring_t));
+    if (!r) return NULL;
+    memset(r, 0, sizeof(*r));
+    r->buf = malloc(cap * elem_size);
+    if (!r->buf) {
+        free(r);
+        return NULL;
+    }
+    atomic_init(&r->tail, 0);
+    atomic_init(&r->head, 0);
+    atomic_init(&r->closed, 0);
+    r->mask = cap - 1;
+    r->elem = elem_size;
+    return r;
+}
+
+void spsc_ring_destroy(spsc_ring_t* r) {
+    if (!r) return;
+    free(r->buf);
+    free(r);
+}
+
+/* Копирует n элементов между кольцом (с позиции index) и линейным буфером */
+static void ring_copy_in(spsc_ring_t* r, size_t index, const unsigned char* src, size_t n) {
+    size_t cap = r->mask + 1;
+    size_t at = index & r->mask;
+    size_t first = n < cap - at ? n : cap - at;
+    memcpy(r->buf + at * r->elem, src, first * r->elem);
+    if (n > first) memcpy(r->buf, src + first * r->elem, (n - first) * r->elem);
+}
+
+static void ring_copy_out(const spsc_ring_t* r, size_t index, unsigned char* dst, size_t n) {
+    size_t cap = r->mask + 1;
+    size_t at = index & r->mask;
+    size_t first = n < cap - at ? n : cap - at;
+    memcpy(dst, r->buf + at * r->elem, first * r->elem);
+    if (n > first) memcpy(dst + first * r->elem, r->buf, (n - first) * r->elem);
+}
+
+size_t spsc_ring_try_push(spsc_ring_t* r, const void* items, size_t n) {
+    size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    size_t cap = r->mask + 1;
+    size_t room = cap - (tail - r->head_cache);
+    if (room < n) {
+        r->head_cache = atomic_load_explicit(&r->head, memory_order_acquire);
+        room = cap - (tail - r->head_cache);
+    }
+    if (n > room) n = room;
+    if (n == 0) return 0;
+    ring_copy_in(r, tail, items, n);
+    atomic_store_explicit(&r->tail, tail + n, memory_order_release);
+    return n;
+}
+
+void spsc_ring_push(spsc_ring_t* r, const void* items, size_t n) {
+    const unsigned char* p = items;
+    int spins = 0;
+    while (n > 0) {
+        size_t k = spsc_ring_try_push(r, p, n);
+        p += k * r->elem;
+        n -= k;
+        if (k) {
+            spins = 0;
+        } else if (++spins >= SPIN_BEFORE_YIELD) {
+            sched_yield();
+            spins = 0;
+        }
+    }
+}
+
+void spsc_ring_close(spsc_ring_t* r) {
+    atomic_store_explicit(&r->closed, 1, memory_order_release);
+}
+
+size_t spsc_ring_try_pop(spsc_ring_t* r, void* out, size_t max) {
+    size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    size_t avail = r->tail_cache - head;
+    if (avail < max) {
+        r->tail_cache = atomic_load_explicit(&r->tail, memory_order_acquire);
+        avail = r->tail_cache - head;
+    }
+    size_t n = avail < max ? avail : max;
+    if (n == 0) return 0;
+    ring_copy_out(r, head, out, n);
+    atomic_store_explicit(&r->head, head + n, memory_order_release);
+    return n;
+}
+
+size_t spsc_ring_pop(spsc_ring_t* r, void* out, size_t max) {
+    int spins = 0;
+    for (;;) {
+        size_t n = spsc_ring_try_pop(r, out, max);
+        if (n) return n;
+        if (atomic_load_explicit(&r->closed, memory_order_acquire)) {
+            // Писатель мог опубликовать последнюю пачку перед закрытием
+            return spsc_ring_try_pop(r, out, max);
+        }
+        if (++spins >= SPIN_BEFORE_YIELD) {
+            sched_yield();
+            spins = 0;
+        }
+    }
+}
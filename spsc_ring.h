@@ -0,0 +1,41 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stddef.h>
+
+/*
+ * Кольцевой буфер без блокировок для одного писателя и одного читателя
+ * (single-producer/single-consumer). Элементы фиксированного размера
+ * копируются в буфер и из него пачками: индекс публикуется один раз
+ * на пачку, поэтому синхронизация стоит O(1) на пачку, а не на элемент.
+ * Ёмкость — степень двойки, индексы растут без переноса и маскируются.
+ */
+typedef struct spsc_ring spsc_ring_t;
+
+/*
+ * Создаёт буфер не меньше чем на capacity элементов размера elem_size
+ * (ёмкость округляется вверх до степени двойки). NULL при ошибке.
+ */
+spsc_ring_t* spsc_ring_create(size_t capacity, size_t elem_size);
+
+void spsc_ring_destroy(spsc_ring_t* r);
+
+/* Писатель: кладёт до n элементов без ожидания, возвращает сколько положил. */
+size_t spsc_ring_try_push(spsc_ring_t* r, const void* items, size_t n);
+
+/* Писатель: кладёт все n элементов, ожидая места. */
+void spsc_ring_push(spsc_ring_t* r, const void* items, size_t n);
+
+/* Писатель: больше элементов не будет. */
+void spsc_ring_close(spsc_ring_t* r);
+
+/* Читатель: забирает до max элементов без ожидания, возвращает сколько забрал. */
+size_t spsc_ring_try_pop(spsc_ring_t* r, void* out, size_t max);
+
+/*
+ * Читатель: забирает до max элементов, ожидая хотя бы одного.
+ * Возвращает 0 только когда буфер закрыт и пуст.
+ */
+size_t spsc_ring_pop(spsc_ring_t* r, void* out, size_t max);
+
+#endif // SPSC_RING_H
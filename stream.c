@@ -0,0 +1,252 @@
+/*
+ * Потоковый режим: вход читается из stdin порциями по мере поступления,
+ * записи идут в sim_t через кучу переупорядочивания по ta, и цикл событий
+ * продвигается вслед за водяным знаком. Память ограничена окном опоздания
+ * и кучей, а не длиной входа.
+ */
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "queue.h"
+#include "trace.h"
+
+#define STREAM_BATCH   1024        // записей за один разбор
+#define STREAM_REORDER (1 << 16)  // ёмкость кучи по умолчанию
+
+/* Запись в куче ожидания: id копируется, буфер чтения переиспользуется */
+typedef struct {
+    int    ta;
+    int    ts;
+    size_t seq;     // номер во входе: при равных ta порядок входа сохраняется
+    int    id_len;
+    char   id[MAX_ID_LEN];
+} reorder_item_t;
+
+/* Двоичная min-куча по (ta, seq) не больше чем на limit записей */
+typedef struct {
+    reorder_item_t* items;
+    size_t          count;
+    size_t          cap;
+    size_t          limit;
+} reorder_heap_t;
+
+typedef struct {
+    sim_t*         sim;
+    reorder_heap_t heap;
+    int            lateness;
+    long long      max_ta;    // наибольший увиденный ta (LLONG_MIN — ещё ничего)
+    long long      floor;     // записи с ta раньше этого опоздали
+    long long      advanced;  // прогон продвинут до этого момента
+    size_t         seq;
+    size_t         late;      // отброшено опоздавших записей
+    size_t         forced;    // отпущено раньше срока из-за полной кучи
+} stream_t;
+
+void sim_stream_config_init(sim_stream_config_t* sc) {
+    sc->lateness = 0;
+    sc->reorder_limit = STREAM_REORDER;
+}
+
+static inline int reorder_less(const reorder_item_t* a, const reorder_item_t* b) {
+    return a->ta != b->ta ? a->ta < b->ta : a->seq < b->seq;
+}
+
+/* Добавляет запись (место уже проверено). 0 или -1 при ошибке realloc */
+static int reorder_push(reorder_heap_t* h, const reorder_item_t* it) {
+    if (h->count == h->cap) {
+        size_t cap = h->cap ? h->cap * 2 : 64;
+        if (cap > h->limit) cap = h->limit;
+        reorder_item_t* tmp = realloc(h->items, cap * sizeof(reorder_item_t));
+        if (!tmp) return -1;
+        h->items = tmp;
+        h->cap = cap;
+    }
+    size_t k = h->count++;
+    while (k > 0) {
+        size_t parent = (k - 1) / 2;
+        if (!reorder_less(it, &h->items[parent])) break;
+        h->items[k] = h->items[parent];
+        k = parent;
+    }
+    h->items[k] = *it;
+    return 0;
+}
+
+/* Снимает самую раннюю запись в *out */
+static void reorder_pop(reorder_heap_t* h, reorder_item_t* out) {
+    *out = h->items[0];
+    reorder_item_t last = h->items[--h->count];
+    size_t n = h->count, k = 0;
+    for (;;) {
+        size_t c = 2 * k + 1;
+        if (c >= n) break;
+        if (c + 1 < n && reorder_less(&h->items[c + 1], &h->items[c])) c++;
+        if (!reorder_less(&h->items[c], &last)) break;
+        h->items[k] = h->items[c];
+        k = c;
+    }
+    if (n) h->items[k] = last;
+}
+
+/* Передаёт запись прогону; всё, что раньше её, с этого момента опоздало */
+static int stream_release(stream_t* st, const reorder_item_t* it) {
+    if (it->ta > st->floor) st->floor = it->ta;
+    return sim_add_arrival(st->sim, it->id, (size_t)it->id_len, it->ta, it->ts);
+}
+
+/*
+ * Принимает запись из входа. Опоздавшая отбрасывается; если куча полна,
+ * раньше срока отпускается самая ранняя из кучи и новой записи.
+ */
+static int stream_accept(stream_t* st, const trace_t* view, const passenger_t* p) {
+    if (p->ta < st->floor) {
+        st->late++;
+        return 0;
+    }
+    reorder_item_t it;
+    it.ta = p->ta;
+    it.ts = p->ts;
+    it.seq = st->seq++;
+    it.id_len = p->id_len;
+    memcpy(it.id, trace_id(view, p), (size_t)p->id_len);
+
+    if (p->ta > st->max_ta) {
+        st->max_ta = p->ta;
+        if (st->max_ta - st->lateness > st->floor) st->floor = st->max_ta - st->lateness;
+    }
+    reorder_heap_t* h = &st->heap;
+    if (h->count == h->limit) {
+        st->forced++;
+        if (!reorder_less(&h->items[0], &it)) return stream_release(st, &it);
+        reorder_item_t first;
+        reorder_pop(h, &first);
+        if (stream_release(st, &first) < 0) return -1;
+    }
+    if (reorder_push(h, &it) < 0) {
+        fprintf(stderr, "Error: malloc failed for reorder buffer\n");
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Отпускает записи раньше водяного знака (все — в конце входа) и продвигает
+ * прогон до момента перед ним: записи с ta на знаке ещё могут прийти.
+ */
+static int stream_flush(stream_t* st, int eof) {
+    reorder_heap_t* h = &st->heap;
+    reorder_item_t it;
+    while (h->count && (eof || h->items[0].ta < st->floor)) {
+        reorder_pop(h, &it);
+        if (stream_release(st, &it) < 0) return -1;
+    }
+    if (eof) return sim_drain(st->sim);
+    if (st->floor > INT_MIN && st->floor - 1 > st->advanced) {
+        st->advanced = st->floor - 1;
+        return sim_advance_until(st->sim, (int)st->advanced);
+    }
+    return 0;
+}
+
+void run_stream_with(const sim_config_t* cfg, const sim_stream_config_t* sc, int metrics_only) {
+    trace_reader_t rd;
+    passenger_t* batch = malloc(STREAM_BATCH * sizeof(passenger_t));
+    if (!batch || trace_reader_open(&rd, stdin) < 0) {
+        fprintf(stderr, "Error: malloc failed for input buffer\n");
+        free(batch);
+        return;
+    }
+
+    stream_t st;
+    memset(&st, 0, sizeof(st));
+    st.heap.limit = sc->reorder_limit ? sc->reorder_limit : STREAM_REORDER;
+    st.lateness = sc->lateness;
+    st.max_ta = st.floor = st.advanced = LLONG_MIN;
+
+    sim_metrics_t metrics;
+    int have_metrics = 0;
+    sim_config_t run_cfg = *cfg;
+    run_cfg.table = !metrics_only && run_cfg.events == SIM_EVENTS_NONE;
+    if (run_cfg.table_block) run_cfg.table_out = stdout;
+
+    trace_t view;
+    trace_cursor_t cur;
+    size_t skipped = 0;
+    int eof = 0, failed = 1;
+    int hrc = trace_reader_header(&rd, &view, &cur);
+    if (hrc < 0) {
+        fprintf(stderr, hrc == -1 ? "Error: failed to read number of desks\n" : "Error: failed to read input\n");
+    } else if (view.desks < 2) {
+        fprintf(stderr, "Error: at least 2 desks are required, but N=%d\n", view.desks);
+    } else if (metrics_only && sim_metrics_init(&metrics, view.desks) < 0) {
+        fprintf(stderr, "Error: malloc failed for metrics\n");
+    } else {
+        if (metrics_only) {
+            have_metrics = 1;
+            run_cfg.metrics = &metrics;
+        }
+        st.sim = sim_create(&run_cfg, view.desks);
+        failed = !st.sim;
+    }
+
+    while (!failed) {
+        eof = rd.eof;
+        size_t n;
+        while (!failed && (n = trace_parse_batch(&view, &cur, batch, STREAM_BATCH)) > 0) {
+            for (size_t i = 0; i < n; i++) {
+                // sim_t не принимает отрицательное время обслуживания: такая запись испорчена
+                if (batch[i].ts < 0) {
+                    skipped++;
+                    continue;
+                }
+                if (stream_accept(&st, &view, &batch[i]) < 0) {
+                    failed = 1;
+                    break;
+                }
+            }
+        }
+        skipped += cur.skipped;
+        cur.skipped = 0;
+        if (failed || stream_flush(&st, eof) < 0) {
+            failed = 1;
+            break;
+        }
+        // Блоки таблицы сбрасываются сами, журнал событий — здесь, чтобы не копился
+        if (run_cfg.events != SIM_EVENTS_NONE) fflush(run_cfg.events_out ? run_cfg.events_out : stdout);
+        if (eof) break;
+        if (trace_reader_next(&rd, &view, &cur) < 0) {
+            fprintf(stderr, "Error: failed to read input\n");
+            failed = 1;
+        }
+    }
+
+    if (st.sim && eof && !failed) {
+        if (skipped) {
+            fprintf(stderr, "Warning: skipped %zu malformed records (expected id/ta/ts)\n", skipped);
+        }
+        if (st.late) {
+            fprintf(stderr, "Warning: dropped %zu passengers that arrived behind the watermark "
+                            "(lateness %d)\n", st.late, st.lateness);
+        }
+        if (st.forced) {
+            fprintf(stderr, "Warning: reorder buffer was full %zu times, earliest passengers "
+                            "were released early\n", st.forced);
+        }
+        sim_stats_t stats;
+        sim_get_stats(st.sim, &stats);
+        if (stats.rejected) {
+            fprintf(stderr, "Warning: %zu passengers were rejected by full desk queues\n", stats.rejected);
+        }
+        const sim_table_t* table = sim_get_table(st.sim);
+        if (table) sim_table_print(table, stdout);
+        sim_destroy(st.sim);
+        if (have_metrics) sim_metrics_print(&metrics, stdout);
+    } else {
+        sim_destroy(st.sim);
+    }
+    if (have_metrics) sim_metrics_free(&metrics);
+    free(st.heap.items);
+    free(batch);
+    trace_reader_close(&rd);
+}
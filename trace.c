@@ -0,0 +1,526 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "queue.h"
+#include "trace.h"
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define TRACE_READ_CHUNK    (1 << 20)  // размер блока чтения для каналов
+#define TRACE_READER_CHUNK  (1 << 16)  // начальный буфер trace_reader_t: байт за одно чтение
+#define TRACE_INITIAL_ITEMS 1024
+
+
+// ----- Загрузка входа ----- //
+
+void trace_init_buffer(trace_t* tr, const char* data, size_t size) {
+    memset(tr, 0, sizeof(*tr));
+    tr->data = (char*)data;
+    tr->size = size;
+}
+
+/*
+ * Пытается отобразить обычный файл за потоком in в память.
+ * Возвращает 1 при успехе, 0 если поток нельзя отобразить (канал и т.п.).
+ */
+static int trace_try_map(trace_t* tr, FILE* in) {
+#ifndef _WIN32
+    int fd = fileno(in);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) return 0;
+
+    // Поток мог быть уже частично прочитан — начинаем с текущей позиции
+    off_t start = lseek(fd, 0, SEEK_CUR);
+    if (start < 0 || start > st.st_size) return 0;
+    size_t total = (size_t)st.st_size;
+    if (total == (size_t)start) {
+        tr->data = NULL;
+        tr->size = 0;
+        return 1;
+    }
+
+    void* base = mmap(NULL, total, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (base == MAP_FAILED) return 0;
+#ifdef MADV_SEQUENTIAL
+    madvise(base, total, MADV_SEQUENTIAL);
+#endif
+    tr->map_base = base;
+    tr->map_len  = total;
+    tr->data     = (char*)base + start;
+    tr->size     = total - (size_t)start;
+    tr->mapped   = 1;
+    tr->owned    = 1;
+    return 1;
+#else
+    (void)tr; (void)in;
+    return 0;
+#endif
+}
+
+int trace_load_stream(trace_t* tr, FILE* in) {
+    trace_init_buffer(tr, NULL, 0);
+    if (trace_try_map(tr, in)) return 0;
+
+    // Запасной путь: дочитываем поток целиком большими блоками
+    size_t cap = TRACE_READ_CHUNK;
+    char* buf = malloc(cap);
+    if (!buf) return -1;
+    size_t len = 0;
+    for (;;) {
+        if (len == cap) {
+            char* tmp = realloc(buf, cap * 2);
+            if (!tmp) { free(buf); return -1; }
+            buf = tmp;
+            cap *= 2;
+        }
+        size_t got = fread(buf + len, 1, cap - len, in);
+        len += got;
+        if (got == 0) break;
+    }
+    if (ferror(in)) { free(buf); return -1; }
+    tr->data  = buf;
+    tr->size  = len;
+    tr->owned = 1;
+    return 0;
+}
+
+void trace_free(trace_t* tr) {
+    if (tr->owned) {
+#ifndef _WIN32
+        if (tr->mapped) munmap(tr->map_base, tr->map_len);
+        else
+#endif
+        free(tr->data);
+    }
+    free(tr->items);
+    memset(tr, 0, sizeof(*tr));
+}
+
+
+// ----- Токенизатор ----- //
+
+/* Разделители токенов: пробельные и прочие управляющие символы (<= ' ') */
+static inline int is_sep(unsigned char c) {
+    return c <= ' ';
+}
+
+/* Первый не-разделитель в [p, end) */
+static const char* skip_seps(const char* p, const char* end) {
+    while (p < end && is_sep((unsigned char)*p)) p++;
+    return p;
+}
+
+/*
+ * Первый разделитель в [p, end). Токены обычно короткие, но на длинных
+ * строках без пробелов SSE2 проверяет по 16 байт за раз.
+ */
+static const char* find_sep(const char* p, const char* end) {
+#if defined(__SSE2__)
+    const __m128i space = _mm_set1_epi8(' ');
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        // v <= ' ' (беззнаково) <=> min(v, ' ') == v
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(v, space), v));
+        if (mask) return p + __builtin_ctz((unsigned)mask);
+        p += 16;
+    }
+#endif
+    while (p < end && !is_sep((unsigned char)*p)) p++;
+    return p;
+}
+
+/*
+ * Разбор целого в духе atoi: необязательный знак и цифры до первой не-цифры.
+ * Если цифр нет — 0.
+ */
+static int parse_int(const char* p, const char* end) {
+    int neg = 0;
+    if (p < end && (*p == '-' || *p == '+')) {
+        neg = (*p == '-');
+        p++;
+    }
+    unsigned v = 0;
+    while (p < end && (unsigned)(*p - '0') < 10) {
+        v = v * 10 + (unsigned)(*p - '0');
+        p++;
+    }
+    return neg ? (int)(0u - v) : (int)v;  // -2147483648 без переполнения int
+}
+
+int trace_reserve(trace_t* tr, size_t extra) {
+    size_t need = tr->count + extra;
+    if (need <= tr->cap) return 0;
+    size_t newcap = tr->cap ? tr->cap : TRACE_INITIAL_ITEMS;
+    while (newcap < need) newcap *= 2;
+    passenger_t* tmp = realloc(tr->items, newcap * sizeof(passenger_t));
+    if (!tmp) return -1;
+    tr->items = tmp;
+    tr->cap = newcap;
+    return 0;
+}
+
+static int trace_push(trace_t* tr, const passenger_t* p) {
+    if (tr->count == tr->cap && trace_reserve(tr, 1) < 0) return -1;
+    tr->items[tr->count++] = *p;
+    return 0;
+}
+
+/*
+ * Делит токен [p, end) на поля по '/'. Пустые поля пропускаются
+ * (как это делал strtok), лишние поля после третьего игнорируются.
+ * Возвращает 1, если найдены все три поля.
+ */
+static int parse_record(const trace_t* tr, const char* p, const char* end, passenger_t* out) {
+    const char* field[3];
+    const char* field_end[3];
+    int n = 0;
+    while (n < 3 && p < end) {
+        if (*p == '/') { p++; continue; }
+        const char* slash = memchr(p, '/', (size_t)(end - p));
+        const char* fe = slash ? slash : end;
+        field[n] = p;
+        field_end[n] = fe;
+        n++;
+        p = fe;
+    }
+    if (n < 3) return 0;
+
+    size_t len = (size_t)(field_end[0] - field[0]);
+    if (len > MAX_ID_LEN - 1) len = MAX_ID_LEN - 1;
+    out->id_off = (size_t)(field[0] - tr->data);
+    out->id_len = (int)len;
+    out->ta = parse_int(field[1], field_end[1]);
+    out->ts = parse_int(field[2], field_end[2]);
+    return 1;
+}
+
+int trace_parse_header(trace_t* tr, trace_cursor_t* cur) {
+    const char* p   = tr->data;
+    const char* end = tr->data + tr->size;
+
+    // Заголовок: число стоек
+    p = skip_seps(p, end);
+    const char* tok_end = find_sep(p, end);
+    const char* q = p;
+    if (q < tok_end && (*q == '-' || *q == '+')) q++;
+    if (q == tok_end || (unsigned)(*q - '0') >= 10) return -1;
+    tr->desks = parse_int(p, tok_end);
+    cur->pos = (size_t)(tok_end - tr->data);
+    cur->skipped = 0;
+    return 0;
+}
+
+/* Следующая запись после позиции *pp: 1 — записана в *out, 0 — данные кончились */
+static int parse_next(const trace_t* tr, const char** pp, passenger_t* out, size_t* skipped) {
+    const char* p   = *pp;
+    const char* end = tr->data + tr->size;
+    for (;;) {
+        p = skip_seps(p, end);
+        if (p == end) {
+            *pp = p;
+            return 0;
+        }
+        const char* tok_end = find_sep(p, end);
+        int ok = parse_record(tr, p, tok_end, out);
+        p = tok_end;
+        if (ok) {
+            *pp = p;
+            return 1;
+        }
+        (*skipped)++;
+    }
+}
+
+size_t trace_parse_batch(const trace_t* tr, trace_cursor_t* cur, passenger_t* out, size_t max) {
+    const char* p = tr->data + cur->pos;
+    size_t n = 0;
+    while (n < max && parse_next(tr, &p, &out[n], &cur->skipped)) n++;
+    cur->pos = (size_t)(p - tr->data);
+    return n;
+}
+
+// ----- Чтение порциями ----- //
+
+int trace_reader_open(trace_reader_t* rd, FILE* in) {
+    memset(rd, 0, sizeof(*rd));
+    rd->in = in;
+    rd->cap = TRACE_READER_CHUNK;
+    rd->buf = malloc(rd->cap);
+    return rd->buf ? 0 : -1;
+}
+
+void trace_reader_close(trace_reader_t* rd) {
+    free(rd->buf);
+    memset(rd, 0, sizeof(*rd));
+}
+
+/*
+ * Читает до n байт, не дожидаясь заполнения всего буфера (fread на канале
+ * ждал бы). Число байт, 0 в конце входа или -1 при ошибке.
+ */
+static long reader_read(FILE* in, char* p, size_t n) {
+#ifndef _WIN32
+    ssize_t r;
+    do {
+        r = read(fileno(in), p, n);
+    } while (r < 0 && errno == EINTR);
+    return (long)r;
+#else
+    size_t r = fread(p, 1, n, in);
+    return r == 0 && ferror(in) ? -1 : (long)r;
+#endif
+}
+
+int trace_reader_next(trace_reader_t* rd, trace_t* view, trace_cursor_t* cur) {
+    memmove(rd->buf, rd->buf + cur->pos, rd->len - cur->pos);
+    rd->len -= cur->pos;
+    cur->pos = 0;
+    if (!rd->eof) {
+        if (rd->len == rd->cap) {
+            // Токен длиннее буфера: растим
+            char* tmp = realloc(rd->buf, rd->cap * 2);
+            if (!tmp) return -1;
+            rd->buf = tmp;
+            rd->cap *= 2;
+        }
+        long r = reader_read(rd->in, rd->buf + rd->len, rd->cap - rd->len);
+        if (r < 0) return -1;
+        if (r == 0) rd->eof = 1;
+        rd->len += (size_t)r;
+    }
+    // Без конца входа последний токен может быть недочитан: отдаём до последнего разделителя
+    size_t done = rd->len;
+    if (!rd->eof) {
+        while (done > 0 && !is_sep((unsigned char)rd->buf[done - 1])) done--;
+    }
+    size_t skipped = view->skipped;
+    int desks = view->desks;
+    trace_init_buffer(view, rd->buf, done);
+    view->skipped = skipped;
+    view->desks = desks;
+    return rd->eof ? 0 : 1;
+}
+
+int trace_reader_header(trace_reader_t* rd, trace_t* view, trace_cursor_t* cur) {
+    trace_init_buffer(view, NULL, 0);
+    cur->pos = 0;
+    cur->skipped = 0;
+    for (;;) {
+        int rc = trace_reader_next(rd, view, cur);
+        if (rc < 0) return -2;
+        // Ждём, пока в целой части появится хоть один токен
+        if (skip_seps(view->data, view->data + view->size) < view->data + view->size) break;
+        if (rc == 0) return -1;
+    }
+    return trace_parse_header(view, cur) < 0 ? -1 : 0;
+}
+
+int trace_parse(trace_t* tr) {
+    trace_cursor_t cur;
+    if (trace_parse_header(tr, &cur) < 0) return -1;
+
+    // Записи id/ta/ts до конца данных
+    const char* p = tr->data + cur.pos;
+    passenger_t rec;
+    while (parse_next(tr, &p, &rec, &tr->skipped)) {
+        if (trace_push(tr, &rec) < 0) return -2;
+    }
+    return 0;
+}
+
+
+// ----- Сортировка ----- //
+
+#define SORT_DIGIT_BITS   8
+#define SORT_BUCKETS      (1 << SORT_DIGIT_BITS)
+#define SORT_PASSES       (32 / SORT_DIGIT_BITS)
+#define SORT_PARALLEL_MIN (1 << 20)  // от стольких записей сортировка идёт в несколько потоков
+#define SORT_MAX_THREADS  16
+
+/*
+ * Запасной компаратор (если не хватило памяти под ключи): сравнение без
+ * вычитания, которое переполняется на далёких ta. Записи разбираются
+ * в порядке входа, поэтому id_off при равных ta сохраняет этот порядок.
+ */
+static int cmp_arr(const void* a, const void* b) {
+    const passenger_t* pa = (const passenger_t*)a;
+    const passenger_t* pb = (const passenger_t*)b;
+    if (pa->ta != pb->ta) return pa->ta < pb->ta ? -1 : 1;
+    return (pa->id_off > pb->id_off) - (pa->id_off < pb->id_off);
+}
+
+/*
+ * Поразрядная сортировка (LSD) ключей: в старших 32 битах — ta со сдвигом
+ * знака (беззнаковый порядок совпадает со знаковым), в младших — номер
+ * записи. Перемещаются только 8-байтовые ключи; каждый проход устойчив,
+ * поэтому при равных ta сохраняется порядок входа. Проходы, где все
+ * ключи попадают в одну корзину, пропускаются.
+ *
+ * Массив делится на threads непрерывных кусков. Поток считает гистограмму
+ * своего куска, затем раскладывает его по смещениям: корзина b потока t
+ * идёт после корзин < b всех потоков и корзины b потоков < t — раскладка
+ * остаётся устойчивой при любом числе потоков.
+ */
+typedef struct {
+    uint64_t* src;
+    uint64_t* dst;
+    size_t    n;
+    int       threads;
+    int       shift;                          // текущий разряд
+    size_t    hist[SORT_MAX_THREADS][SORT_BUCKETS];
+    const passenger_t* items;                 // сбор записей по отсортированным ключам
+    passenger_t*       out;
+} radix_sort_t;
+
+typedef struct {
+    radix_sort_t* rs;
+    int           part;
+} radix_part_t;
+
+static void radix_range(const radix_sort_t* rs, int part, size_t* lo, size_t* hi) {
+    *lo = rs->n * (size_t)part / (size_t)rs->threads;
+    *hi = rs->n * (size_t)(part + 1) / (size_t)rs->threads;
+}
+
+static void* radix_count(void* arg) {
+    radix_part_t* rp = arg;
+    radix_sort_t* rs = rp->rs;
+    size_t lo, hi;
+    radix_range(rs, rp->part, &lo, &hi);
+    size_t* h = rs->hist[rp->part];
+    memset(h, 0, SORT_BUCKETS * sizeof(size_t));
+    for (size_t i = lo; i < hi; i++) h[(rs->src[i] >> rs->shift) & (SORT_BUCKETS - 1)]++;
+    return NULL;
+}
+
+/* Раскладка куска; hist[part] к этому моменту — смещения корзин */
+static void* radix_scatter(void* arg) {
+    radix_part_t* rp = arg;
+    radix_sort_t* rs = rp->rs;
+    size_t lo, hi;
+    radix_range(rs, rp->part, &lo, &hi);
+    size_t* off = rs->hist[rp->part];
+    for (size_t i = lo; i < hi; i++) {
+        uint64_t k = rs->src[i];
+        rs->dst[off[(k >> rs->shift) & (SORT_BUCKETS - 1)]++] = k;
+    }
+    return NULL;
+}
+
+static void* radix_gather(void* arg) {
+    radix_part_t* rp = arg;
+    radix_sort_t* rs = rp->rs;
+    size_t lo, hi;
+    radix_range(rs, rp->part, &lo, &hi);
+    for (size_t i = lo; i < hi; i++) rs->out[i] = rs->items[(uint32_t)rs->src[i]];
+    return NULL;
+}
+
+/* Выполняет fn для всех кусков: первый в этом потоке, остальные в своих (или здесь же, если поток не создался) */
+static void radix_run(radix_sort_t* rs, void* (*fn)(void*)) {
+    radix_part_t parts[SORT_MAX_THREADS];
+    pthread_t tids[SORT_MAX_THREADS];
+    int started[SORT_MAX_THREADS];
+    for (int t = 0; t < rs->threads; t++) {
+        parts[t].rs = rs;
+        parts[t].part = t;
+        started[t] = t > 0 && pthread_create(&tids[t], NULL, fn, &parts[t]) == 0;
+    }
+    for (int t = 0; t < rs->threads; t++) {
+        if (!started[t]) fn(&parts[t]);
+    }
+    for (int t = 1; t < rs->threads; t++) {
+        if (started[t]) pthread_join(tids[t], NULL);
+    }
+}
+
+static int sort_threads(size_t n) {
+    if (n < SORT_PARALLEL_MIN) return 1;
+    long ncpu = 1;
+#ifndef _WIN32
+    ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    long by_size = (long)(n / (SORT_PARALLEL_MIN / 2));  // не меньше полмиллиона записей на поток
+    if (ncpu > by_size) ncpu = by_size;
+    if (ncpu > SORT_MAX_THREADS) ncpu = SORT_MAX_THREADS;
+    return ncpu > 1 ? (int)ncpu : 1;
+}
+
+void trace_sort(trace_t* tr) {
+    size_t n = tr->count;
+    passenger_t* items = tr->items;
+
+    // Быстрый путь: вход почти всегда уже упорядочен по ta
+    size_t i = 1;
+    while (i < n && items[i - 1].ta <= items[i].ta) i++;
+    if (i >= n) return;
+
+    uint64_t* keys = n <= UINT32_MAX ? malloc(2 * n * sizeof(uint64_t)) : NULL;
+    passenger_t* out = keys ? malloc(tr->cap * sizeof(passenger_t)) : NULL;
+    if (!out) {
+        free(keys);
+        qsort(items, n, sizeof(passenger_t), cmp_arr);
+        return;
+    }
+
+    radix_sort_t* rs = malloc(sizeof(radix_sort_t));
+    if (!rs) {
+        free(keys);
+        free(out);
+        qsort(items, n, sizeof(passenger_t), cmp_arr);
+        return;
+    }
+    rs->src = keys;
+    rs->dst = keys + n;
+    rs->n = n;
+    rs->threads = sort_threads(n);
+    rs->items = items;
+    rs->out = out;
+
+    // Ключи и сразу видно, какие разряды у всех ключей одинаковы
+    uint32_t all_or = 0, all_and = UINT32_MAX;
+    for (size_t k = 0; k < n; k++) {
+        uint32_t ta = (uint32_t)items[k].ta ^ 0x80000000u;
+        all_or |= ta;
+        all_and &= ta;
+        keys[k] = (uint64_t)ta << 32 | (uint64_t)k;
+    }
+    uint32_t differ = all_or ^ all_and;
+
+    for (int pass = 0; pass < SORT_PASSES; pass++) {
+        int shift = 32 + pass * SORT_DIGIT_BITS;
+        if (!((differ >> (shift - 32)) & (SORT_BUCKETS - 1))) continue;
+        rs->shift = shift;
+        radix_run(rs, radix_count);
+        // Смещения: по корзинам, внутри корзины — по потокам
+        size_t sum = 0;
+        for (int b = 0; b < SORT_BUCKETS; b++) {
+            for (int t = 0; t < rs->threads; t++) {
+                size_t c = rs->hist[t][b];
+                rs->hist[t][b] = sum;
+                sum += c;
+            }
+        }
+        radix_run(rs, radix_scatter);
+        uint64_t* tmp = rs->src;
+        rs->src = rs->dst;
+        rs->dst = tmp;
+    }
+
+    // Записи переставляются один раз, по итоговому порядку номеров
+    radix_run(rs, radix_gather);
+    tr->items = out;
+    free(items);
+    free(keys);
+    free(rs);
+}
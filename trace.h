@@ -0,0 +1,133 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+/*
+ * Запись одного пассажира из входной трассы.
+ * id не копируется: хранится как срез (смещение + длина) в буфере трассы,
+ * поэтому запись остаётся маленькой, а сама строка не завершается '\0'.
+ */
+typedef struct {
+    size_t id_off;  // смещение id в trace_t.data
+    int    id_len;  // длина id (не больше MAX_ID_LEN - 1)
+    int    ta;      // время прибытия
+    int    ts;      // время обслуживания
+} passenger_t;
+
+/*
+ * Входная трасса: сырое содержимое входа и разобранные записи.
+ * - data/size — либо отображённый через mmap файл (mapped = 1),
+ *   либо буфер, в который вход дочитан целиком (mapped = 0).
+ * - items[0..count-1] — записи id/ta/ts в порядке появления во входе.
+ */
+typedef struct {
+    char*        data;
+    size_t       size;
+    int          mapped;
+    int          owned;    // 1, если data нужно освобождать/отображение снимать
+    void*        map_base; // начало отображения (data может быть сдвинута от него)
+    size_t       map_len;
+
+    int          desks;    // число стоек N из заголовка
+    passenger_t* items;
+    size_t       count;
+    size_t       cap;
+    size_t       skipped;  // токены, не похожие на id/ta/ts
+} trace_t;
+
+/*
+ * Загружает вход из потока. Если за ним стоит обычный файл, он отображается
+ * через mmap без копирования; иначе (канал, терминал) поток дочитывается
+ * большими блоками в растущий буфер.
+ * Возвращает 0 при успехе, -1 при ошибке ввода-вывода или malloc.
+ */
+int trace_load_stream(trace_t* tr, FILE* in);
+
+/*
+ * Инициализирует трассу поверх чужого буфера (он не освобождается в trace_free).
+ */
+void trace_init_buffer(trace_t* tr, const char* data, size_t size);
+
+/*
+ * Разбирает загруженный вход: сначала целое N, затем токены id/ta/ts,
+ * разделённые пробельными символами, до конца данных.
+ * Возвращает 0 при успехе, -1 если не удалось прочитать N, -2 при ошибке malloc.
+ */
+int trace_parse(trace_t* tr);
+
+/*
+ * Потоковый разбор: позиция в данных и число пропущенных токенов.
+ * Позволяет разбирать вход порциями (например, в отдельном потоке),
+ * не складывая записи в tr->items.
+ */
+typedef struct {
+    size_t pos;      // смещение в tr->data, с которого продолжать
+    size_t skipped;  // токены, не похожие на id/ta/ts
+} trace_cursor_t;
+
+/* Читает N в tr->desks и ставит курсор за ним. 0 или -1, если N нет. */
+int trace_parse_header(trace_t* tr, trace_cursor_t* cur);
+
+/*
+ * Разбирает до max следующих записей в out. Трассу не меняет, поэтому
+ * безопасна параллельно с работой другого потока над tr->items.
+ * Возвращает число записей; 0 — данные кончились.
+ */
+size_t trace_parse_batch(const trace_t* tr, trace_cursor_t* cur, passenger_t* out, size_t max);
+
+/*
+ * Чтение входа порциями по мере поступления (канал, живой источник), без
+ * загрузки целиком. В буфере копятся ещё не разобранные байты; разбирать
+ * можно только целые токены — их отдаёт trace_reader_next как трассу-вид
+ * view поверх буфера (id записей ссылаются в буфер до следующего вызова).
+ */
+typedef struct {
+    FILE*  in;
+    char*  buf;
+    size_t cap;
+    size_t len;
+    int    eof;
+} trace_reader_t;
+
+/* 0 или -1 при ошибке malloc. */
+int trace_reader_open(trace_reader_t* rd, FILE* in);
+
+void trace_reader_close(trace_reader_t* rd);
+
+/*
+ * Выбрасывает разобранное начало буфера [0, cur->pos), дочитывает следующую
+ * порцию (не дожидаясь заполнения буфера) и ставит view на целые токены,
+ * а cur->pos — в 0 (cur->skipped копится). Возвращает 1 — прочитана порция,
+ * 0 — вход кончился (view — весь остаток), -1 — ошибка чтения или malloc.
+ */
+int trace_reader_next(trace_reader_t* rd, trace_t* view, trace_cursor_t* cur);
+
+/*
+ * Читает до первого целого токена и разбирает из него N (как
+ * trace_parse_header). view и cur затем указывают на остаток порции.
+ * Возвращает 0, -1 если N нет, -2 при ошибке чтения или malloc.
+ */
+int trace_reader_header(trace_reader_t* rd, trace_t* view, trace_cursor_t* cur);
+
+/* Гарантирует место ещё под extra записей в tr->items. 0 или -1 при ошибке malloc. */
+int trace_reserve(trace_t* tr, size_t extra);
+
+/*
+ * Сортирует записи по возрастанию времени прибытия ta, устойчиво: при равных
+ * ta сохраняется порядок входа. Уже упорядоченная трасса только проверяется
+ * за один проход; иначе — поразрядная сортировка, на больших трассах
+ * в нескольких потоках.
+ */
+void trace_sort(trace_t* tr);
+
+/* Освобождает записи и буфер (или снимает отображение) трассы. */
+void trace_free(trace_t* tr);
+
+/* Указатель на первый символ id пассажира p (строка не завершена '\0'). */
+static inline const char* trace_id(const trace_t* tr, const passenger_t* p) {
+    return tr->data + p->id_off;
+}
+
+#endif // TRACE_H
@@ -0,0 +1,110 @@
+/*
+ * Генератор синтетических трасс прихода для нагрузочных прогонов queue_app.
+ * Пишет текст в текущем формате (N, затем записи id/ta/ts) потоково,
+ * блоками по TRACEGEN_BUF байт, так что размер трассы не ограничен памятью.
+ *
+ *   tracegen --desks=64 --passengers=100000000 --arrivals=bursty:8:50 \
+ *            --service=pareto:1.5:2 --id-len=6:12 --seed=7 --output=trace.txt
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "queue.h"
+#include "workload.h"
+
+#define TRACEGEN_BUF (4 << 20)
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  --desks=N          number of desks in the header (default 4)\n"
+            "  --passengers=N     number of records (default 10000)\n"
+            "  --rate=R           mean arrivals per time unit (default: 80%% load)\n"
+            "  --arrivals=SPEC    poisson | bursty:FACTOR:LEN (default poisson)\n"
+            "  --service=SPEC     const:A | uniform:A:B | exp:MEAN | pareto:ALPHA:XMIN |\n"
+            "                     lognormal:MU:SIGMA (default exp:5)\n"
+            "  --id-len=L|MIN:MAX passenger id length (default 8)\n"
+            "  --seed=S           generator seed (default 1)\n"
+            "  --output=FILE      write to FILE instead of stdout\n"
+            "  --quiet            do not print throughput to stderr\n",
+            prog);
+}
+
+int main(int argc, char** argv) {
+    workload_t w;
+    workload_init(&w);
+    const char* output = NULL;
+    int quiet = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        int ok = 1;
+        if      (strncmp(a, "--desks=", 8) == 0)       { w.desks = atoi(a + 8); ok = w.desks >= 1; }
+        else if (strncmp(a, "--passengers=", 13) == 0) { w.passengers = strtoull(a + 13, NULL, 10); }
+        else if (strncmp(a, "--rate=", 7) == 0)        { w.rate = atof(a + 7); ok = w.rate >= 0; }
+        else if (strncmp(a, "--arrivals=", 11) == 0)   { ok = workload_parse_arrivals(&w, a + 11) == 0; }
+        else if (strncmp(a, "--service=", 10) == 0)    { ok = workload_parse_service(&w, a + 10) == 0; }
+        else if (strncmp(a, "--id-len=", 9) == 0)      { ok = workload_parse_id_len(&w, a + 9) == 0; }
+        else if (strncmp(a, "--seed=", 7) == 0)        { w.seed = strtoull(a + 7, NULL, 10); }
+        else if (strncmp(a, "--output=", 9) == 0)      { output = a + 9; }
+        else if (strcmp(a, "--quiet") == 0)            { quiet = 1; }
+        else {
+            usage(argv[0]);
+            return strcmp(a, "--help") == 0 ? 0 : 1;
+        }
+        if (!ok) {
+            fprintf(stderr, "Error: invalid option '%s'\n", a);
+            return 1;
+        }
+    }
+
+    FILE* out = output ? fopen(output, "wb") : stdout;
+    if (!out) {
+        fprintf(stderr, "Error: cannot open '%s' for writing\n", output);
+        return 1;
+    }
+    char* buf = malloc(TRACEGEN_BUF);
+    if (!buf) {
+        fprintf(stderr, "Error: malloc failed for output buffer\n");
+        if (output) fclose(out);
+        return 1;
+    }
+    // Пишем своими большими блоками, буфер stdio не нужен
+    setvbuf(out, NULL, _IONBF, 0);
+
+    workload_gen_t g;
+    workload_gen_init(&g, &w);
+    double t0 = now_sec();
+    size_t bytes = 0;
+    int rc = 0;
+    for (;;) {
+        size_t n = workload_gen_fill(&g, buf, TRACEGEN_BUF);
+        if (n == 0) break;
+        if (fwrite(buf, 1, n, out) != n) {
+            fprintf(stderr, "Error: write failed after %zu bytes\n", bytes);
+            rc = 1;
+            break;
+        }
+        bytes += n;
+    }
+    if (rc == 0 && (fputc('\n', out) == EOF || fflush(out) != 0)) {
+        fprintf(stderr, "Error: write failed after %zu bytes\n", bytes);
+        rc = 1;
+    }
+    double dt = now_sec() - t0;
+
+    if (!quiet && rc == 0) {
+        fprintf(stderr, "Generated %zu records, %.1f MB in %.2f s (%.0f MB/s)\n",
+                g.next, bytes / 1e6, dt, dt > 0 ? bytes / 1e6 / dt : 0.0);
+    }
+    free(buf);
+    if (output && fclose(out) != 0) rc = 1;
+    return rc;
+}
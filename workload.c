@@ -0,0 +1,270 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "queue.h"
+#include "workload.h"
+
+// ----- Распределения поверх rng_t ----- //
+
+/* Экспоненциальное со средним mean */
+static double next_exp(rng_t* s, double mean) {
+    return -mean * log(1.0 - rng_unit(s));
+}
+
+/* Стандартное нормальное (Бокс — Мюллер, одна половина пары) */
+static double next_normal(rng_t* s) {
+    double u = 1.0 - rng_unit(s);
+    double v = rng_unit(s);
+    return sqrt(-2.0 * log(u)) * cos(6.283185307179586 * v);
+}
+
+static int sample_service(const workload_t* w, rng_t* s) {
+    double x;
+    switch (w->service) {
+    case SERVICE_CONST:
+        x = w->service_a;
+        break;
+    case SERVICE_UNIFORM:
+        x = w->service_a + rng_unit(s) * (w->service_b - w->service_a + 1.0);
+        break;
+    case SERVICE_PARETO:
+        x = w->service_b / pow(1.0 - rng_unit(s), 1.0 / w->service_a);
+        break;
+    case SERVICE_LOGNORMAL:
+        x = exp(w->service_a + w->service_b * next_normal(s));
+        break;
+    case SERVICE_EXP:
+    default:
+        x = next_exp(s, w->service_a);
+        break;
+    }
+    // Хвосты тяжёлых распределений обрезаем, чтобы время влезало в int
+    if (x > 1e9) x = 1e9;
+    return x > 0 ? (int)x : 0;
+}
+
+
+// ----- Параметры ----- //
+
+void workload_init(workload_t* w) {
+    w->desks        = 4;
+    w->passengers   = 10000;
+    w->rate         = 0.0;  // 0 — подобрать под загрузку 80%
+    w->arrivals     = ARRIVAL_POISSON;
+    w->burst_factor = 1.0;
+    w->burst_len    = 0.0;
+    w->service      = SERVICE_EXP;
+    w->service_a    = 5.0;
+    w->service_b    = 0.0;
+    w->id_len       = 8;
+    w->id_len_min   = 0;
+    w->seed         = 1;
+}
+
+int workload_parse_service(workload_t* w, const char* spec) {
+    double a, b;
+    if (sscanf(spec, "const:%lf", &a) == 1) {
+        w->service = SERVICE_CONST;
+        w->service_a = a;
+        return a >= 0 ? 0 : -1;
+    }
+    if (sscanf(spec, "uniform:%lf:%lf", &a, &b) == 2) {
+        w->service = SERVICE_UNIFORM;
+        w->service_a = a;
+        w->service_b = b;
+        return (a >= 0 && b >= a) ? 0 : -1;
+    }
+    if (sscanf(spec, "exp:%lf", &a) == 1) {
+        w->service = SERVICE_EXP;
+        w->service_a = a;
+        return a > 0 ? 0 : -1;
+    }
+    if (sscanf(spec, "pareto:%lf:%lf", &a, &b) == 2) {
+        w->service = SERVICE_PARETO;
+        w->service_a = a;
+        w->service_b = b;
+        return (a > 0 && b > 0) ? 0 : -1;
+    }
+    if (sscanf(spec, "lognormal:%lf:%lf", &a, &b) == 2) {
+        w->service = SERVICE_LOGNORMAL;
+        w->service_a = a;
+        w->service_b = b;
+        return b >= 0 ? 0 : -1;
+    }
+    return -1;
+}
+
+int workload_parse_arrivals(workload_t* w, const char* spec) {
+    double f, len;
+    if (strcmp(spec, "poisson") == 0) {
+        w->arrivals = ARRIVAL_POISSON;
+        return 0;
+    }
+    if (sscanf(spec, "bursty:%lf:%lf", &f, &len) == 2) {
+        w->arrivals = ARRIVAL_BURSTY;
+        w->burst_factor = f;
+        w->burst_len = len;
+        return (f >= 1.0 && len > 0) ? 0 : -1;
+    }
+    return -1;
+}
+
+int workload_parse_id_len(workload_t* w, const char* spec) {
+    int lo, hi;
+    if (sscanf(spec, "%d:%d", &lo, &hi) == 2) {
+        w->id_len_min = lo;
+        w->id_len = hi;
+        return (lo >= 1 && lo <= hi && hi < MAX_ID_LEN) ? 0 : -1;
+    }
+    if (sscanf(spec, "%d", &hi) == 1) {
+        w->id_len_min = 0;
+        w->id_len = hi;
+        return (hi >= 1 && hi < MAX_ID_LEN) ? 0 : -1;
+    }
+    return -1;
+}
+
+void workload_format_service(const workload_t* w, char* buf, size_t size) {
+    switch (w->service) {
+    case SERVICE_CONST:     snprintf(buf, size, "const:%g", w->service_a); break;
+    case SERVICE_UNIFORM:   snprintf(buf, size, "uniform:%g:%g", w->service_a, w->service_b); break;
+    case SERVICE_EXP:       snprintf(buf, size, "exp:%g", w->service_a); break;
+    case SERVICE_PARETO:    snprintf(buf, size, "pareto:%g:%g", w->service_a, w->service_b); break;
+    case SERVICE_LOGNORMAL: snprintf(buf, size, "lognormal:%g:%g", w->service_a, w->service_b); break;
+    }
+}
+
+void workload_format_arrivals(const workload_t* w, char* buf, size_t size) {
+    if (w->arrivals == ARRIVAL_BURSTY) {
+        snprintf(buf, size, "bursty:%g:%g", w->burst_factor, w->burst_len);
+    } else {
+        snprintf(buf, size, "poisson");
+    }
+}
+
+double workload_mean_service(const workload_t* w) {
+    switch (w->service) {
+    case SERVICE_CONST:     return w->service_a;
+    case SERVICE_UNIFORM:   return (w->service_a + w->service_b) / 2.0;
+    case SERVICE_PARETO:    return w->service_a > 1.0 ? w->service_a * w->service_b / (w->service_a - 1.0)
+                                                      : w->service_b * 10.0;  // бесконечное среднее
+    case SERVICE_LOGNORMAL: return exp(w->service_a + w->service_b * w->service_b / 2.0);
+    case SERVICE_EXP:
+    default:                return w->service_a;
+    }
+}
+
+double workload_effective_rate(const workload_t* w) {
+    if (w->rate > 0) return w->rate;
+    double mean = workload_mean_service(w);
+    return mean > 0 ? 0.8 * w->desks / mean : 1.0;
+}
+
+
+// ----- Генерация ----- //
+
+/* Пишет неотрицательное v в десятичном виде, возвращает конец записи */
+static char* put_uint(char* p, unsigned v) {
+    char tmp[12];
+    int n = 0;
+    do {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    while (n) *p++ = tmp[--n];
+    return p;
+}
+
+/* id из id_len символов: номер пассажира в base36 с ведущими нулями */
+static char* put_id(char* p, size_t num, int id_len) {
+    static const char digits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+    for (int i = id_len - 1; i >= 0; i--) {
+        p[i] = digits[num % 36];
+        num /= 36;
+    }
+    return p + id_len;
+}
+
+void workload_gen_init(workload_gen_t* g, const workload_t* w) {
+    g->w = *w;
+    if (g->w.id_len < 1) g->w.id_len = 1;
+    if (g->w.id_len > MAX_ID_LEN - 1) g->w.id_len = MAX_ID_LEN - 1;
+    g->rate = workload_effective_rate(w);
+    rng_seed(&g->rng, w->seed);
+    g->next = 0;
+    g->clock = 0.0;
+    g->burst_end = 0.0;
+    g->header_done = 0;
+}
+
+/* Время следующего прихода */
+static double next_arrival(workload_gen_t* g) {
+    if (g->w.arrivals != ARRIVAL_BURSTY || g->w.burst_factor <= 1.0) {
+        g->clock += next_exp(&g->rng, 1.0 / g->rate);
+        return g->clock;
+    }
+    // Всплески: внутри ON-периода приходы с интенсивностью rate * factor,
+    // ON длится в среднем burst_len, OFF — burst_len * (factor - 1),
+    // так что средняя интенсивность остаётся rate
+    double on_rate = g->rate * g->w.burst_factor;
+    for (;;) {
+        double t = g->clock + next_exp(&g->rng, 1.0 / on_rate);
+        if (t < g->burst_end) {
+            g->clock = t;
+            return t;
+        }
+        double off = next_exp(&g->rng, g->w.burst_len * (g->w.burst_factor - 1.0));
+        g->clock = g->burst_end + off;
+        g->burst_end = g->clock + next_exp(&g->rng, g->w.burst_len);
+    }
+}
+
+size_t workload_gen_fill(workload_gen_t* g, char* buf, size_t cap) {
+    char* p = buf;
+    char* end = buf + cap;
+    if (!g->header_done) {
+        p = put_uint(p, (unsigned)g->w.desks);
+        *p++ = '\n';
+        g->header_done = 1;
+    }
+    int span = (g->w.id_len_min > 0 && g->w.id_len_min < g->w.id_len)
+             ? g->w.id_len - g->w.id_len_min + 1 : 0;
+    while (g->next < g->w.passengers && end - p >= WORKLOAD_RECORD_MAX) {
+        size_t i = g->next++;
+        double ta = next_arrival(g);
+        int ts = sample_service(&g->w, &g->rng);
+        int id_len = span ? g->w.id_len_min + (int)rng_bounded(&g->rng, (uint32_t)span) : g->w.id_len;
+        p = put_id(p, i, id_len);
+        *p++ = '/';
+        p = put_uint(p, ta < 2e9 ? (unsigned)ta : 2000000000u);
+        *p++ = '/';
+        p = put_uint(p, (unsigned)ts);
+        *p++ = (i % 16 == 15) ? '\n' : ' ';
+    }
+    return (size_t)(p - buf);
+}
+
+char* workload_generate(const workload_t* w, size_t* len) {
+    workload_gen_t g;
+    workload_gen_init(&g, w);
+
+    size_t cap = 16 + w->passengers * (size_t)(g.w.id_len + 24);
+    if (cap < WORKLOAD_RECORD_MAX * 2) cap = WORKLOAD_RECORD_MAX * 2;
+    char* buf = malloc(cap);
+    if (!buf) return NULL;
+    size_t used = 0;
+    for (;;) {
+        if (cap - used < WORKLOAD_RECORD_MAX) {
+            char* tmp = realloc(buf, cap * 2);
+            if (!tmp) { free(buf); return NULL; }
+            buf = tmp;
+            cap *= 2;
+        }
+        size_t n = workload_gen_fill(&g, buf + used, cap - used);
+        if (n == 0) break;
+        used += n;
+    }
+    *len = used;
+    return buf;
+}
@@ -0,0 +1,98 @@
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "rng.h"
+
+/*
+ * Генератор синтетических входов для бенчмарков и tracegen: текст в формате
+ * queue_app (N, затем записи id/ta/ts в порядке прихода). Генерирует потоково,
+ * блоками в буфер вызывающего, поэтому размер трассы памятью не ограничен.
+ */
+
+/* Поток приходов */
+typedef enum {
+    ARRIVAL_POISSON,  // пуассоновский со средней интенсивностью rate
+    ARRIVAL_BURSTY    // всплески: ON-периоды с интенсивностью rate * burst_factor, между ними тишина
+} arrival_dist_t;
+
+/* Распределение времени обслуживания */
+typedef enum {
+    SERVICE_CONST,     // всегда a
+    SERVICE_UNIFORM,   // равномерно на [a, b]
+    SERVICE_EXP,       // экспоненциальное со средним a
+    SERVICE_PARETO,    // Парето: хвост alpha = a, минимум b
+    SERVICE_LOGNORMAL  // логнормальное: mu = a, sigma = b
+} service_dist_t;
+
+typedef struct {
+    int            desks;         // число стоек N
+    size_t         passengers;    // число записей
+    double         rate;          // среднее число приходов за единицу времени (0 — загрузка 80%)
+    arrival_dist_t arrivals;
+    double         burst_factor;  // во сколько раз интенсивность всплеска выше средней
+    double         burst_len;     // средняя длина всплеска
+    service_dist_t service;
+    double         service_a;
+    double         service_b;
+    int            id_len;        // длина id (1..MAX_ID_LEN-1)
+    int            id_len_min;    // если 0 < id_len_min < id_len — длина равномерна на [min, id_len]
+    uint64_t       seed;
+} workload_t;
+
+/* Заполняет w значениями по умолчанию. */
+void workload_init(workload_t* w);
+
+/*
+ * Разбирает описание распределения обслуживания: "const:A", "uniform:A:B",
+ * "exp:MEAN", "pareto:ALPHA:XMIN" или "lognormal:MU:SIGMA".
+ * Возвращает 0 при успехе, -1 при ошибке формата.
+ */
+int workload_parse_service(workload_t* w, const char* spec);
+
+/* Разбирает поток приходов: "poisson" или "bursty:FACTOR:LEN". 0 или -1. */
+int workload_parse_arrivals(workload_t* w, const char* spec);
+
+/* Разбирает длину id: "L" или "MIN:MAX". 0 или -1. */
+int workload_parse_id_len(workload_t* w, const char* spec);
+
+/* Пишет описание распределений в buf (в том же формате, что принимают parse). */
+void workload_format_service(const workload_t* w, char* buf, size_t size);
+void workload_format_arrivals(const workload_t* w, char* buf, size_t size);
+
+/* Среднее время обслуживания для распределения w. */
+double workload_mean_service(const workload_t* w);
+
+/* Интенсивность приходов: w->rate или, если он 0, загрузка 80% по среднему обслуживанию. */
+double workload_effective_rate(const workload_t* w);
+
+/* Состояние потокового генератора. */
+typedef struct {
+    workload_t w;
+    double     rate;       // действующая средняя интенсивность
+    rng_t      rng;
+    size_t     next;       // номер следующей записи
+    double     clock;      // время последнего прихода
+    double     burst_end;  // конец текущего всплеска (ARRIVAL_BURSTY)
+    int        header_done;
+} workload_gen_t;
+
+void workload_gen_init(workload_gen_t* g, const workload_t* w);
+
+/*
+ * Дописывает в buf целые записи (первым вызовом — заголовок N), не больше cap байт.
+ * Возвращает число записанных байт; 0 — трасса закончилась.
+ * cap должен быть не меньше 2 * WORKLOAD_RECORD_MAX (заголовок + запись).
+ */
+size_t workload_gen_fill(workload_gen_t* g, char* buf, size_t cap);
+
+#define WORKLOAD_RECORD_MAX 64  // верхняя граница длины одной записи с разделителем
+
+/*
+ * Генерирует вход целиком в память. Возвращает буфер в куче (освобождать free)
+ * и его длину в *len, либо NULL при ошибке malloc.
+ */
+char* workload_generate(const workload_t* w, size_t* len);
+
+#endif // WORKLOAD_H